@@ -26,6 +26,10 @@ struct option long_options[] = {
     { "list-properties", no_argument,    nullptr, 'l' },
     { "set-property", required_argument, nullptr, 'o' },
     { "noautomute", no_argument,         nullptr, 'm' },
+    { "trace-assets", required_argument, nullptr, 't' },
+    { "texture-budget", required_argument, nullptr, 'g' },
+    { "texture-atlas", no_argument,      nullptr, 'x' },
+    { "compress-textures", no_argument,  nullptr, 'z' },
     { nullptr, 0,                        nullptr, 0 }
 };
 
@@ -57,11 +61,15 @@ CApplicationContext::CApplicationContext (int argc, char* argv[])
             .defaultBackground = "",
             .screenBackgrounds = {},
             .properties = {},
+            .assetTraceTime = 0,
         },
         .render =
         {
             .mode = NORMAL_WINDOW,
             .maximumFPS = 30,
+            .textureBudget = 0,
+            .textureAtlas = false,
+            .textureCompression = false,
             .window = { .geometry = {}},
         },
         .audio =
@@ -178,6 +186,22 @@ CApplicationContext::CApplicationContext (int argc, char* argv[])
         case 'm':
             this->settings.audio.automute = false;
             break;
+
+        case 't':
+            this->settings.general.assetTraceTime = std::max (atoi (optarg), 0);
+            break;
+
+        case 'g':
+            this->settings.render.textureBudget = std::max (atoi (optarg), 0);
+            break;
+
+        case 'x':
+            this->settings.render.textureAtlas = true;
+            break;
+
+        case 'z':
+            this->settings.render.textureCompression = true;
+            break;
         default:
             sLog.out ("Default on path parsing: ", optarg);
             break;
@@ -272,4 +296,8 @@ void CApplicationContext::printHelp (const char* route)
     sLog.out ("\t--screenshot\t\t\t\tTakes a screenshot of the background");
     sLog.out ("\t--list-properties\t\t\tList all the available properties and their possible values");
     sLog.out ("\t--set-property <name=value>\tOverrides the default value of the given property");
+    sLog.out ("\t--trace-assets <seconds>\tRecords the files read during the first seconds and reads them ahead on the next launch");
+    sLog.out ("\t--texture-budget <MiB>\t\tLimits the GPU memory used by textures, unused textures are unloaded when it's exceeded");
+    sLog.out ("\t--texture-atlas\t\t\tPacks small textures into shared atlases to reduce texture switches (experimental)");
+    sLog.out ("\t--compress-textures\t\tCompresses PNG/JPEG textures to DXT when loading them, uses less GPU memory at the cost of quality");
 }
\ No newline at end of file
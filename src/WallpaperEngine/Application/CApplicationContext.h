@@ -50,6 +50,8 @@ namespace WallpaperEngine::Application
                 std::map <std::string, std::filesystem::path> screenBackgrounds;
                 /** Properties to change values for */
                 std::map <std::string, std::string> properties;
+                /** Seconds of file accesses to record in the asset trace, 0 disables asset traces */
+                int assetTraceTime;
             } general;
 
             /**
@@ -61,6 +63,12 @@ namespace WallpaperEngine::Application
                 WINDOW_MODE mode;
                 /** Maximum FPS */
                 int maximumFPS;
+                /** GPU memory the textures can use (in MiB), 0 means no limit */
+                int textureBudget;
+                /** Whether small textures are packed into shared atlases */
+                bool textureAtlas;
+                /** Whether embedded images (PNG, JPEG...) are compressed to DXT after decoding them */
+                bool textureCompression;
 
                 struct
                 {
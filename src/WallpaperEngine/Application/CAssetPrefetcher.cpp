@@ -0,0 +1,125 @@
+#include "CAssetPrefetcher.h"
+
+#include "WallpaperEngine/Core/Objects/CImage.h"
+#include "WallpaperEngine/Core/Objects/CSound.h"
+#include "WallpaperEngine/Threading/CThreadPool.h"
+
+#include <unistd.h>
+
+namespace WallpaperEngine::Application
+{
+    CAssetPrefetcher::CAssetPrefetcher (Core::CProject* project) :
+        m_container (project->getContainer ()),
+        m_cancelled (std::make_shared <std::atomic <bool>> (false))
+    {
+        if (project->getWallpaper ()->is <Core::CScene> ())
+            this->collect (project->getWallpaper ()->as <Core::CScene> ());
+    }
+
+    CAssetPrefetcher::~CAssetPrefetcher ()
+    {
+        this->stop ();
+    }
+
+    void CAssetPrefetcher::collect (Core::CScene* scene)
+    {
+        for (const auto& cur : scene->getObjects ())
+        {
+            Core::CObject* object = cur.second;
+
+            if (object->is <Core::Objects::CImage> ())
+                this->collect (object->as <Core::Objects::CImage> ()->getMaterial ());
+            else if (object->is <Core::Objects::CSound> ())
+                for (const auto& sound : object->as <Core::Objects::CSound> ()->getSounds ())
+                    this->addFile (sound);
+
+            for (const auto& effect : object->getEffects ())
+                for (const auto& material : effect->getMaterials ())
+                    this->collect (material);
+        }
+    }
+
+    void CAssetPrefetcher::collect (const Core::Objects::Images::CMaterial* material)
+    {
+        for (const auto& pass : material->getPasses ())
+        {
+            for (const auto& texture : pass->getTextures ())
+            {
+                // render targets are not files
+                if (texture.empty () || texture.find ("_rt_") == 0)
+                    continue;
+
+                this->addFile ("materials/" + texture + ".tex");
+            }
+
+            this->addFile ("shaders/" + pass->getShader () + ".vert");
+            this->addFile ("shaders/" + pass->getShader () + ".frag");
+        }
+    }
+
+    void CAssetPrefetcher::addFile (const std::string& filename)
+    {
+        if (!this->m_found.insert (filename).second)
+            return;
+
+        this->m_files.push_back (filename);
+    }
+
+    void CAssetPrefetcher::start ()
+    {
+        static const long pageSize = sysconf (_SC_PAGESIZE);
+
+        this->m_tasks.reserve (this->m_tasks.size () + this->m_files.size ());
+
+        for (const auto& cur : this->m_files)
+        {
+            CContainer* container = this->m_container;
+            std::shared_ptr <std::atomic <bool>> cancelled = this->m_cancelled;
+
+            this->m_tasks.push_back (Threading::CThreadPool::get ().submit ([container, cancelled, cur] ()
+            {
+                // the container might be gone already
+                if (*cancelled)
+                    return;
+
+                uint32_t length = 0;
+                std::shared_ptr <const uint8_t[]> contents = container->tryReadFile (cur, &length);
+
+                if (contents == nullptr)
+                    return;
+
+                // files coming from packages are mapped, touch every page so they're read from disk here
+                // instead of when the main thread gets to them
+                volatile uint8_t sink = 0;
+
+                for (uint32_t offset = 0; offset < length; offset += pageSize)
+                    sink += contents [offset];
+            }));
+        }
+    }
+
+    void CAssetPrefetcher::stop ()
+    {
+        *this->m_cancelled = true;
+
+        // reads that already started cannot be interrupted, their results are not needed anymore
+        for (auto& cur : this->m_tasks)
+        {
+            try
+            {
+                Threading::CThreadPool::get ().wait (cur);
+            }
+            catch (std::exception& e)
+            {
+                // prefetching is only a hint, errors show up when the files are actually used
+            }
+        }
+
+        this->m_tasks.clear ();
+    }
+
+    const std::vector <std::string>& CAssetPrefetcher::getFiles () const
+    {
+        return this->m_files;
+    }
+}
@@ -0,0 +1,80 @@
+#pragma once
+
+#include <atomic>
+#include <future>
+#include <memory>
+#include <set>
+#include <string>
+#include <vector>
+
+#include "WallpaperEngine/Assets/CContainer.h"
+#include "WallpaperEngine/Core/CProject.h"
+#include "WallpaperEngine/Core/CScene.h"
+#include "WallpaperEngine/Core/Objects/Images/CMaterial.h"
+
+namespace WallpaperEngine::Application
+{
+    using namespace WallpaperEngine::Assets;
+
+    /**
+     * Walks a parsed background looking for the files the render setup is going to read (textures, shaders, sounds...)
+     * and reads them on the thread pool ahead of time, so by the time the render setup needs them they're already
+     * in memory (page cache and container caches) instead of being read one after the other on the main thread
+     *
+     * The reads use the project's container, so the prefetcher must be destroyed before the container is
+     */
+    class CAssetPrefetcher
+    {
+    public:
+        explicit CAssetPrefetcher (Core::CProject* project);
+        /**
+         * Cancels the reads that didn't start yet and waits for the rest to finish
+         */
+        ~CAssetPrefetcher ();
+
+        /**
+         * Queues the reads of all the files found on the thread pool, this returns immediately
+         */
+        void start ();
+        /**
+         * Cancels the reads that didn't start yet and waits for the rest to finish
+         */
+        void stop ();
+
+        /**
+         * @return The files that will be prefetched, in the order they were found
+         */
+        [[nodiscard]] const std::vector <std::string>& getFiles () const;
+
+    private:
+        /**
+         * Collects the files used by the objects in the scene
+         *
+         * @param scene
+         */
+        void collect (Core::CScene* scene);
+        /**
+         * Collects the textures and shaders used by the material's passes
+         *
+         * @param material
+         */
+        void collect (const Core::Objects::Images::CMaterial* material);
+        /**
+         * Adds the file to the list if it was not added already
+         *
+         * @param filename
+         */
+        void addFile (const std::string& filename);
+
+        /** The container the files are read from */
+        CContainer* m_container;
+        /** Files to prefetch */
+        std::vector <std::string> m_files;
+        /** Files already in the list */
+        std::set <std::string> m_found;
+        /** The queued reads */
+        std::vector <std::future <void>> m_tasks;
+        /** Tells the queued reads to not do anything, shared with them */
+        std::shared_ptr <std::atomic <bool>> m_cancelled;
+    };
+}
@@ -1,4 +1,5 @@
 #include "CWallpaperApplication.h"
+#include "CAssetPrefetcher.h"
 
 #include "Steam/FileSystem/FileSystem.h"
 #include "WallpaperEngine/Assets/CDirectory.h"
@@ -12,6 +13,7 @@
 #include "WallpaperEngine/Application/CApplicationState.h"
 #include "WallpaperEngine/Render/Drivers/Detectors/CX11FullScreenDetector.h"
 #include "WallpaperEngine/Audio/Drivers/Detectors/CPulseAudioPlayingDetector.h"
+#include "WallpaperEngine/FileSystem/FileSystem.h"
 
 #include <unistd.h>
 
@@ -24,10 +26,20 @@ namespace WallpaperEngine::Application
         m_context (context),
         m_defaultBackground (nullptr)
     {
+        if (this->m_context.settings.general.assetTraceTime > 0)
+            this->replayAssetTraces ();
+
         this->loadBackgrounds ();
         this->setupProperties ();
     }
 
+    CWallpaperApplication::~CWallpaperApplication ()
+    {
+        // the reads use the backgrounds' containers
+        for (auto cur : this->m_prefetchers)
+            delete cur;
+    }
+
     void CWallpaperApplication::setupContainer (CCombinedContainer& container, const std::string& bg) const
     {
         std::filesystem::path basepath = bg;
@@ -183,13 +195,88 @@ namespace WallpaperEngine::Application
             this->m_defaultBackground = this->loadBackground (this->m_context.settings.general.defaultBackground);
     }
 
+    std::filesystem::path CWallpaperApplication::getAssetTracePath (const std::string& bg)
+    {
+        std::string absolute = std::filesystem::absolute (bg).lexically_normal ();
+
+        return WallpaperEngine::FileSystem::cacheDirectory ("traces") /
+            (std::to_string (std::hash <std::string> {} (absolute)) + ".trace");
+    }
+
+    void CWallpaperApplication::replayAssetTraces () const
+    {
+        std::vector <std::string> backgrounds;
+
+        for (const auto& it : this->m_context.settings.general.screenBackgrounds)
+            if (!it.second.empty ())
+                backgrounds.push_back (it.second);
+
+        if (!this->m_context.settings.general.defaultBackground.empty ())
+            backgrounds.push_back (this->m_context.settings.general.defaultBackground);
+
+        for (const auto& bg : backgrounds)
+        {
+            try
+            {
+                uint64_t bytes = CAssetTrace::replay (getAssetTracePath (bg));
+
+                if (bytes > 0)
+                    sLog.out ("Reading ahead ", bytes, " bytes from the asset trace of ", bg);
+            }
+            catch (std::runtime_error& ex)
+            {
+                sLog.error ("Cannot replay asset trace for ", bg, ": ", ex.what ());
+            }
+        }
+    }
+
+    void CWallpaperApplication::saveAssetTraces ()
+    {
+        for (const auto& it : this->m_assetTraces)
+        {
+            if (!it.second->isRecording ())
+                continue;
+
+            it.second->stop ();
+
+            try
+            {
+                it.second->save (getAssetTracePath (it.first));
+            }
+            catch (std::runtime_error& ex)
+            {
+                sLog.error ("Cannot save asset trace for ", it.first, ": ", ex.what ());
+            }
+        }
+    }
+
     Core::CProject* CWallpaperApplication::loadBackground (const std::string& bg)
     {
         auto* container = new CCombinedContainer ();
 
         this->setupContainer (*container, bg);
 
-        return Core::CProject::fromFile ("project.json", container);
+        if (this->m_context.settings.general.assetTraceTime > 0)
+        {
+            // the same background might be used in multiple screens
+            auto trace = this->m_assetTraces.find (bg);
+
+            if (trace == this->m_assetTraces.end ())
+                trace = this->m_assetTraces.insert (std::make_pair (bg, new CAssetTrace ())).first;
+
+            container->setTrace (trace->second);
+        }
+
+        Core::CProject* project = Core::CProject::fromFile ("project.json", container);
+
+        // start reading the files the background needs while the rest of the setup happens
+        auto prefetcher = new CAssetPrefetcher (project);
+
+        prefetcher->start ();
+
+        this->m_prefetchers.push_back (prefetcher);
+
+        return project;
     }
 
     void CWallpaperApplication::setupPropertiesForProject (Core::CProject* project)
@@ -328,6 +415,10 @@ namespace WallpaperEngine::Application
             startTime = g_Time;
             // render the scene
             context.render ();
+
+            // the background has been running for long enough, store what it used
+            if (g_Time >= this->m_context.settings.general.assetTraceTime)
+                this->saveAssetTraces ();
             // get the end time of the frame
             endTime = videoDriver.getRenderTime ();
 
@@ -346,6 +437,9 @@ namespace WallpaperEngine::Application
         // ensure this is updated as sometimes it might not come from a signal
         this->m_context.state.general.keepRunning = false;
 
+        // closed before the trace time was reached, store whatever was recorded
+        this->saveAssetTraces ();
+
         sLog.out ("Stop requested");
 
         SDL_Quit ();
@@ -1,7 +1,9 @@
 #pragma once
 
 #include "WallpaperEngine/Application/CApplicationContext.h"
+#include "WallpaperEngine/Application/CAssetPrefetcher.h"
 
+#include "WallpaperEngine/Assets/CAssetTrace.h"
 #include "WallpaperEngine/Assets/CCombinedContainer.h"
 
 #include "WallpaperEngine/Core/CProject.h"
@@ -21,6 +23,7 @@ namespace WallpaperEngine::Application
     {
     public:
         explicit CWallpaperApplication (CApplicationContext& context);
+        ~CWallpaperApplication ();
 
         /**
          * Shows the application until it's closed
@@ -57,6 +60,19 @@ namespace WallpaperEngine::Application
          * Loads projects based off the settings
          */
         void loadBackgrounds ();
+        /**
+         * Reads ahead the files recorded in the asset traces of the backgrounds to load
+         */
+        void replayAssetTraces () const;
+        /**
+         * Stops recording the asset traces and writes them to disk
+         */
+        void saveAssetTraces ();
+        /**
+         * @param bg The background's path
+         * @return Path to the asset trace file of the given background
+         */
+        static std::filesystem::path getAssetTracePath (const std::string& bg);
         /**
          * Loads the given project
          *
@@ -89,5 +105,9 @@ namespace WallpaperEngine::Application
         CApplicationContext& m_context;
         /** Maps screens to backgrounds */
         std::map <std::string, Core::CProject*> m_backgrounds;
+        /** Asset traces being recorded for the backgrounds' paths */
+        std::map <std::string, CAssetTrace*> m_assetTraces;
+        /** Files being read ahead for the backgrounds, stopped before the backgrounds go away */
+        std::vector <CAssetPrefetcher*> m_prefetchers;
     };
 }
@@ -0,0 +1,198 @@
+#include "BlockCompression.h"
+
+#include <algorithm>
+#include <cstdlib>
+
+using namespace WallpaperEngine::Assets;
+
+/**
+ * Copies the 4x4 block at the given position, the pixels outside of the image repeat the last row/column
+ */
+static void loadBlock (const uint8_t* source, uint32_t pitch, uint32_t width, uint32_t height, uint32_t x, uint32_t y, uint8_t block [16][4])
+{
+    for (uint32_t by = 0; by < 4; by ++)
+    {
+        const uint8_t* row = source + static_cast <size_t> (std::min (y + by, height - 1)) * pitch;
+
+        for (uint32_t bx = 0; bx < 4; bx ++)
+        {
+            const uint8_t* pixel = row + std::min (x + bx, width - 1) * 4;
+
+            std::copy (pixel, pixel + 4, block [by * 4 + bx]);
+        }
+    }
+}
+
+static uint16_t to565 (const uint8_t* bgr)
+{
+    return static_cast <uint16_t> (((bgr [2] >> 3) << 11) | ((bgr [1] >> 2) << 5) | (bgr [0] >> 3));
+}
+
+static void from565 (uint16_t color, int* bgr)
+{
+    int b = color & 0x1F, g = (color >> 5) & 0x3F, r = color >> 11;
+
+    bgr [0] = (b << 3) | (b >> 2);
+    bgr [1] = (g << 2) | (g >> 4);
+    bgr [2] = (r << 3) | (r >> 2);
+}
+
+/**
+ * Encodes the color part of a block, the endpoints are the corners of the colors' bounding box
+ * moved a bit inwards, which keeps the error low without searching for the best endpoints
+ */
+static void encodeColorBlock (const uint8_t block [16][4], uint8_t* destination)
+{
+    uint8_t minimum [3] = { 255, 255, 255 };
+    uint8_t maximum [3] = { 0, 0, 0 };
+
+    for (int i = 0; i < 16; i ++)
+    {
+        for (int c = 0; c < 3; c ++)
+        {
+            minimum [c] = std::min (minimum [c], block [i][c]);
+            maximum [c] = std::max (maximum [c], block [i][c]);
+        }
+    }
+
+    for (int c = 0; c < 3; c ++)
+    {
+        int inset = (maximum [c] - minimum [c]) >> 4;
+
+        minimum [c] += inset;
+        maximum [c] -= inset;
+    }
+
+    uint16_t color0 = to565 (maximum);
+    uint16_t color1 = to565 (minimum);
+    uint32_t indices = 0;
+
+    // color0 has to be the biggest one to get the four color mode
+    if (color0 < color1)
+        std::swap (color0, color1);
+
+    if (color0 != color1)
+    {
+        int palette [4][3];
+
+        from565 (color0, palette [0]);
+        from565 (color1, palette [1]);
+
+        for (int c = 0; c < 3; c ++)
+        {
+            palette [2][c] = (2 * palette [0][c] + palette [1][c]) / 3;
+            palette [3][c] = (palette [0][c] + 2 * palette [1][c]) / 3;
+        }
+
+        for (int i = 0; i < 16; i ++)
+        {
+            int best = 0, bestDistance = INT32_MAX;
+
+            for (int p = 0; p < 4; p ++)
+            {
+                int distance = 0;
+
+                for (int c = 0; c < 3; c ++)
+                    distance += (block [i][c] - palette [p][c]) * (block [i][c] - palette [p][c]);
+
+                if (distance < bestDistance)
+                {
+                    best = p;
+                    bestDistance = distance;
+                }
+            }
+
+            indices |= static_cast <uint32_t> (best) << (i * 2);
+        }
+    }
+
+    destination [0] = color0 & 0xFF;
+    destination [1] = color0 >> 8;
+    destination [2] = color1 & 0xFF;
+    destination [3] = color1 >> 8;
+
+    for (int i = 0; i < 4; i ++)
+        destination [4 + i] = (indices >> (i * 8)) & 0xFF;
+}
+
+/**
+ * Encodes the alpha part of a block using the eight value mode
+ */
+static void encodeAlphaBlock (const uint8_t block [16][4], uint8_t* destination)
+{
+    int alpha0 = 0, alpha1 = 255;
+
+    for (int i = 0; i < 16; i ++)
+    {
+        alpha0 = std::max <int> (alpha0, block [i][3]);
+        alpha1 = std::min <int> (alpha1, block [i][3]);
+    }
+
+    uint64_t indices = 0;
+
+    if (alpha0 != alpha1)
+    {
+        int palette [8] = { alpha0, alpha1 };
+
+        for (int p = 2; p < 8; p ++)
+            palette [p] = ((8 - p) * alpha0 + (p - 1) * alpha1) / 7;
+
+        for (int i = 0; i < 16; i ++)
+        {
+            int best = 0, bestDistance = INT32_MAX;
+
+            for (int p = 0; p < 8; p ++)
+            {
+                int distance = std::abs (block [i][3] - palette [p]);
+
+                if (distance < bestDistance)
+                {
+                    best = p;
+                    bestDistance = distance;
+                }
+            }
+
+            indices |= static_cast <uint64_t> (best) << (i * 3);
+        }
+    }
+
+    destination [0] = alpha0;
+    destination [1] = alpha1;
+
+    for (int i = 0; i < 6; i ++)
+        destination [2 + i] = (indices >> (i * 8)) & 0xFF;
+}
+
+size_t BlockCompression::getCompressedSize (uint32_t width, uint32_t height, uint32_t blockSize)
+{
+    return static_cast <size_t> (std::max (1u, (width + 3) / 4)) * std::max (1u, (height + 3) / 4) * blockSize;
+}
+
+void BlockCompression::encodeBC1 (const uint8_t* source, uint32_t pitch, uint32_t width, uint32_t height, uint8_t* destination)
+{
+    uint8_t block [16][4];
+
+    for (uint32_t y = 0; y < height; y += 4)
+    {
+        for (uint32_t x = 0; x < width; x += 4, destination += 8)
+        {
+            loadBlock (source, pitch, width, height, x, y, block);
+            encodeColorBlock (block, destination);
+        }
+    }
+}
+
+void BlockCompression::encodeBC3 (const uint8_t* source, uint32_t pitch, uint32_t width, uint32_t height, uint8_t* destination)
+{
+    uint8_t block [16][4];
+
+    for (uint32_t y = 0; y < height; y += 4)
+    {
+        for (uint32_t x = 0; x < width; x += 4, destination += 16)
+        {
+            loadBlock (source, pitch, width, height, x, y, block);
+            encodeAlphaBlock (block, destination);
+            encodeColorBlock (block, destination + 8);
+        }
+    }
+}
@@ -0,0 +1,38 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+namespace WallpaperEngine::Assets::BlockCompression
+{
+    /**
+     * @param width The width of the image (in pixels)
+     * @param height The height of the image (in pixels)
+     * @param blockSize The size of every 4x4 block (8 for BC1, 16 for BC3)
+     *
+     * @return The size of the compressed image (in bytes)
+     */
+    size_t getCompressedSize (uint32_t width, uint32_t height, uint32_t blockSize);
+
+    /**
+     * Compresses a BGRA image to BC1 (DXT1) ignoring the alpha channel
+     *
+     * @param source The BGRA pixels, rows are laid out in the order they are uploaded
+     * @param pitch The size of every row of pixels (in bytes)
+     * @param width The width of the image (in pixels)
+     * @param height The height of the image (in pixels)
+     * @param destination Where to write the blocks to, must hold getCompressedSize (width, height, 8) bytes
+     */
+    void encodeBC1 (const uint8_t* source, uint32_t pitch, uint32_t width, uint32_t height, uint8_t* destination);
+
+    /**
+     * Compresses a BGRA image to BC3 (DXT5)
+     *
+     * @param source The BGRA pixels, rows are laid out in the order they are uploaded
+     * @param pitch The size of every row of pixels (in bytes)
+     * @param width The width of the image (in pixels)
+     * @param height The height of the image (in pixels)
+     * @param destination Where to write the blocks to, must hold getCompressedSize (width, height, 16) bytes
+     */
+    void encodeBC3 (const uint8_t* source, uint32_t pitch, uint32_t width, uint32_t height, uint8_t* destination);
+}
@@ -0,0 +1,112 @@
+#include "common.h"
+#include "CAssetTrace.h"
+
+#include <algorithm>
+#include <fstream>
+
+#include <fcntl.h>
+#include <unistd.h>
+
+using namespace WallpaperEngine::Assets;
+
+// ranges closer than this are read together, it's cheaper to read a bit more than to seek
+#define TRACE_MERGE_DISTANCE (256 * 1024)
+
+void CAssetTrace::record (const std::filesystem::path& path, uint64_t offset, uint64_t length)
+{
+    std::lock_guard <std::mutex> lock (this->m_mutex);
+
+    if (!this->m_recording)
+        return;
+
+    Entry entry (path, offset, length);
+
+    if (!this->m_recorded.insert (entry).second)
+        return;
+
+    this->m_entries.push_back (entry);
+}
+
+void CAssetTrace::stop ()
+{
+    std::lock_guard <std::mutex> lock (this->m_mutex);
+
+    this->m_recording = false;
+}
+
+bool CAssetTrace::isRecording () const
+{
+    std::lock_guard <std::mutex> lock (this->m_mutex);
+
+    return this->m_recording;
+}
+
+void CAssetTrace::save (const std::filesystem::path& filename) const
+{
+    std::lock_guard <std::mutex> lock (this->m_mutex);
+    std::ofstream output (filename, std::ios::trunc);
+
+    if (!output.is_open ())
+        sLog.exception ("Cannot write asset trace to ", filename);
+
+    for (const auto& cur : this->m_entries)
+        output << cur.offset << " " << cur.length << " " << cur.path << "\n";
+}
+
+uint64_t CAssetTrace::replay (const std::filesystem::path& filename)
+{
+    std::ifstream input (filename);
+    std::vector <Entry> entries;
+    uint64_t offset, length, total = 0;
+    std::string path;
+
+    if (!input.is_open ())
+        return 0;
+
+    while (input >> offset >> length && std::getline (input >> std::ws, path))
+        entries.emplace_back (path, offset, length);
+
+    // sort by file and offset so the reads are as sequential as possible
+    std::sort (entries.begin (), entries.end ());
+
+    for (auto cur = entries.begin (); cur != entries.end (); )
+    {
+        int fd = open (cur->path.c_str (), O_RDONLY);
+
+        if (fd == -1)
+        {
+            // the file is gone, skip all it's ranges
+            std::string skip = cur->path;
+
+            while (cur != entries.end () && cur->path == skip)
+                cur ++;
+
+            continue;
+        }
+
+        auto next = cur;
+
+        while (next != entries.end () && next->path == cur->path)
+        {
+            uint64_t start = next->offset;
+            uint64_t end = next->offset + next->length;
+
+            // merge all the ranges that are close enough into one big read
+            for (next ++; next != entries.end () && next->path == cur->path; next ++)
+            {
+                if (next->offset > end + TRACE_MERGE_DISTANCE)
+                    break;
+
+                end = std::max (end, next->offset + next->length);
+            }
+
+            posix_fadvise (fd, start, end - start, POSIX_FADV_WILLNEED);
+            total += end - start;
+        }
+
+        close (fd);
+        cur = next;
+    }
+
+    return total;
+}
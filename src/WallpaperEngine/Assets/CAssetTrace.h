@@ -0,0 +1,85 @@
+#pragma once
+
+#include <cstdint>
+#include <filesystem>
+#include <mutex>
+#include <set>
+#include <string>
+#include <vector>
+
+namespace WallpaperEngine::Assets
+{
+    /**
+     * Records the byte ranges of the files on disk a background reads, in the order they're read,
+     * so the next launch can request all of them from the disk at once before the background is loaded
+     */
+    class CAssetTrace
+    {
+    public:
+        CAssetTrace () = default;
+
+        /**
+         * Records an access to the given range of a file, does nothing once the trace is stopped
+         *
+         * @param path The file on disk
+         * @param offset Where the read data starts
+         * @param length The length of the read data
+         */
+        void record (const std::filesystem::path& path, uint64_t offset, uint64_t length);
+        /**
+         * Stops recording new accesses
+         */
+        void stop ();
+        /**
+         * @return If the trace is still recording accesses
+         */
+        [[nodiscard]] bool isRecording () const;
+        /**
+         * Writes the trace to the given file
+         *
+         * @param filename
+         */
+        void save (const std::filesystem::path& filename) const;
+
+        /**
+         * Reads a trace file and asks the kernel to read all the ranges in it into the page cache,
+         * ranges are sorted and merged so the disk is read as sequentially as possible
+         *
+         * @param filename The trace file
+         *
+         * @return The amount of bytes requested
+         */
+        static uint64_t replay (const std::filesystem::path& filename);
+
+    private:
+        class Entry
+        {
+        public:
+            Entry (std::string path, uint64_t offset, uint64_t length) :
+                path (std::move (path)),
+                offset (offset),
+                length (length) { }
+
+            bool operator< (const Entry& other) const
+            {
+                if (this->path != other.path)
+                    return this->path < other.path;
+
+                return this->offset < other.offset;
+            }
+
+            std::string path;
+            uint64_t offset;
+            uint64_t length;
+        };
+
+        /** The recorded accesses, in order */
+        std::vector <Entry> m_entries;
+        /** Accesses already recorded to prevent duplicates */
+        std::set <Entry> m_recorded;
+        /** Whether accesses are still being recorded */
+        bool m_recording = true;
+        /** Protects the trace, files can be read from multiple threads */
+        mutable std::mutex m_mutex;
+    };
+}
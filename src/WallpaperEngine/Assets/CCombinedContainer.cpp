@@ -8,13 +8,39 @@ using namespace WallpaperEngine::Assets;
 
 CCombinedContainer::CCombinedContainer () :
     CContainer (),
-    m_containers ()
+    m_containers (),
+    m_trace (nullptr)
 {
 }
 
 void CCombinedContainer::add (CContainer* container)
 {
+    size_t position = this->m_containers.size ();
+    std::vector<std::string> files;
+
     this->m_containers.emplace_back (container);
+
+    if (container->listFiles (files))
+    {
+        // earlier containers take precedence, so emplace won't replace existing entries
+        for (auto& cur : files)
+            this->m_index.emplace (std::move (cur), position);
+    }
+    else
+    {
+        this->m_probed.push_back (position);
+    }
+
+    // the new container can only provide files that were not found before, so forget about those
+    std::lock_guard<std::mutex> lock (this->m_lookupsMutex);
+
+    for (auto cur = this->m_lookups.begin (); cur != this->m_lookups.end (); )
+    {
+        if (cur->second == NotFound)
+            cur = this->m_lookups.erase (cur);
+        else
+            cur ++;
+    }
 }
 
 void CCombinedContainer::addPkg (const std::filesystem::path& path)
@@ -38,42 +64,99 @@ void CCombinedContainer::addPkg (const std::filesystem::path& path)
 }
 
 
-std::filesystem::path CCombinedContainer::resolveRealFile (const std::string& filename) const
+void CCombinedContainer::setTrace (CAssetTrace* trace)
+{
+    this->m_trace = trace;
+}
+
+void CCombinedContainer::record (size_t position, const std::string& filename) const
+{
+    std::filesystem::path path;
+    uint64_t offset = 0, length = 0;
+
+    if (this->m_trace == nullptr || !this->m_trace->isRecording ())
+        return;
+
+    if (this->m_containers [position]->locateFile (filename, path, offset, length))
+        this->m_trace->record (path, offset, length);
+}
+
+size_t CCombinedContainer::find (const std::string& filename, const std::function <bool (size_t)>& probe) const
 {
-    for (auto cur : this->m_containers)
     {
-        try
-        {
-            // try to read the file on the current container, if the file doesn't exists
-            // an exception will be thrown
-            return cur->resolveRealFile (filename);
-        }
-        catch (CAssetLoadException& ex)
-        {
-            // not found in this container, next try
-        }
+        std::lock_guard<std::mutex> lock (this->m_lookupsMutex);
+        auto lookup = this->m_lookups.find (filename);
+
+        if (lookup != this->m_lookups.end ())
+            return lookup->second;
     }
 
-    // no container was able to load the file, abort!
-    throw CAssetLoadException (filename, "Cannot resolve file in any of the containers");
+    auto indexed = this->m_index.find (filename);
+    size_t position = indexed == this->m_index.end () ? NotFound : indexed->second;
+
+    // containers that cannot be indexed have to be checked if they come before the indexed one
+    for (size_t cur : this->m_probed)
+    {
+        if (cur > position)
+            break;
+
+        if (!probe (cur))
+            continue;
+
+        std::lock_guard<std::mutex> lock (this->m_lookupsMutex);
+        this->m_lookups.emplace (filename, cur);
+
+        return cur;
+    }
+
+    // only remember the result if probing was involved, the index already knows about the rest
+    if (!this->m_probed.empty () && this->m_probed.front () < position)
+    {
+        std::lock_guard<std::mutex> lock (this->m_lookupsMutex);
+        this->m_lookups.emplace (filename, position);
+    }
+
+    return position;
 }
 
-const void* CCombinedContainer::readFile (const std::string& filename, uint32_t* length) const
+bool CCombinedContainer::tryResolveRealFile (const std::string& filename, std::filesystem::path& path) const
 {
-    for (auto cur : this->m_containers)
+    bool resolved = false;
+
+    size_t position = this->find (filename, [&] (size_t cur)
     {
-        try
-        {
-            // try to read the file on the current container, if the file doesn't exists
-            // an exception will be thrown
-            return cur->readFile (filename, length);
-        }
-        catch (CAssetLoadException& ex)
-        {
-            // not found in this container, next try
-        }
-    }
+        resolved = this->m_containers [cur]->tryResolveRealFile (filename, path);
+        return resolved;
+    });
+
+    if (position == NotFound)
+        return false;
+
+    if (resolved)
+        return true;
 
-    // no container was able to load the file, abort!
-    throw CAssetLoadException (filename, "Cannot find file in any of the containers");
-}
\ No newline at end of file
+    // the file is resolved through the same container it would be read from
+    return this->m_containers [position]->tryResolveRealFile (filename, path);
+}
+
+std::shared_ptr <const uint8_t[]> CCombinedContainer::tryReadFile (const std::string& filename, uint32_t* length) const
+{
+    std::shared_ptr <const uint8_t[]> contents = nullptr;
+
+    size_t position = this->find (filename, [&] (size_t cur)
+    {
+        contents = this->m_containers [cur]->tryReadFile (filename, length);
+        return contents != nullptr;
+    });
+
+    if (position == NotFound)
+        return nullptr;
+
+    this->record (position, filename);
+
+    // probing the container already read the file
+    if (contents != nullptr)
+        return contents;
+
+    return this->m_containers [position]->tryReadFile (filename, length);
+}
@@ -1,15 +1,24 @@
 #pragma once
 
 #include "CContainer.h"
+#include "CAssetTrace.h"
 
+#include <cstdint>
 #include <filesystem>
+#include <functional>
+#include <mutex>
 #include <stdexcept>
+#include <unordered_map>
 #include <vector>
 
 namespace WallpaperEngine::Assets
 {
     /**
      * A meta-container that allows backgrounds to have files spread across different containers
+     *
+     * Containers that can list their files are indexed when added, so looking up a file is a single
+     * hash probe instead of asking every container in order. Containers that cannot (like directories)
+     * are probed in order and the result of the lookup is remembered for the next time
      */
     class CCombinedContainer : public CContainer
     {
@@ -17,7 +26,7 @@ namespace WallpaperEngine::Assets
         CCombinedContainer ();
 
         /**
-         * Adds a container to the list
+         * Adds a container to the list, containers added first take precedence over the later ones
          *
          * @param container
          */
@@ -28,14 +37,51 @@ namespace WallpaperEngine::Assets
          * @param path
          */
         void addPkg (const std::filesystem::path& path);
+        /**
+         * Sets the trace to record the files read through this container in
+         *
+         * @param trace The trace to record accesses in, nullptr to stop recording
+         */
+        void setTrace (CAssetTrace* trace);
 
         /** @inheritdoc */
-        [[nodiscard]] std::filesystem::path resolveRealFile (const std::string& filename) const override;
+        bool tryResolveRealFile (const std::string& filename, std::filesystem::path& path) const override;
         /** @inheritdoc */
-        [[nodiscard]] const void* readFile (const std::string& filename, uint32_t* length) const override;
+        [[nodiscard]] std::shared_ptr <const uint8_t[]> tryReadFile (const std::string& filename, uint32_t* length) const override;
 
     private:
+        /**
+         * Finds the first container that has the given file
+         *
+         * @param filename The file to look for
+         * @param probe Checks if the container at the given position has the file, called for the containers
+         *              that are not indexed
+         *
+         * @return The position of the container, NotFound if no container has the file
+         */
+        size_t find (const std::string& filename, const std::function <bool (size_t)>& probe) const;
+        /**
+         * Records the read of the given file in the trace (if any)
+         *
+         * @param position The container the file was read from
+         * @param filename The file that was read
+         */
+        void record (size_t position, const std::string& filename) const;
+
+        /** Marks a file as not present in any of the containers */
+        static constexpr size_t NotFound = SIZE_MAX;
+
         /** The list of containers to search files off from */
         std::vector<CContainer*> m_containers;
+        /** Files of the containers that can list them and the position of the first container that has them */
+        std::unordered_map<std::string, size_t> m_index;
+        /** Positions of the containers that cannot list their files, in the order they should be probed */
+        std::vector<size_t> m_probed;
+        /** Results of lookups that required probing containers */
+        mutable std::unordered_map<std::string, size_t> m_lookups;
+        /** The trace to record file reads in */
+        CAssetTrace* m_trace;
+        /** Protects the lookups, files can be read from multiple threads */
+        mutable std::mutex m_lookupsMutex;
     };
 };
\ No newline at end of file
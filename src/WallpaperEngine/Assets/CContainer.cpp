@@ -11,7 +11,37 @@ using namespace WallpaperEngine::Assets;
 
 std::filesystem::path CContainer::resolveRealFile (const std::string& filename) const
 {
-    throw CAssetLoadException (filename, "Cannot resolve physical file in this container");
+    std::filesystem::path path;
+
+    if (!this->tryResolveRealFile (filename, path))
+        throw CAssetLoadException (filename, "Cannot resolve physical file");
+
+    return path;
+}
+
+bool CContainer::tryResolveRealFile (const std::string& filename, std::filesystem::path& path) const
+{
+    return false;
+}
+
+std::shared_ptr <const uint8_t[]> CContainer::readFile (const std::string& filename, uint32_t* length) const
+{
+    std::shared_ptr <const uint8_t[]> contents = this->tryReadFile (filename, length);
+
+    if (contents == nullptr)
+        throw CAssetLoadException (filename, "Cannot find file");
+
+    return contents;
+}
+
+bool CContainer::listFiles (std::vector <std::string>& files) const
+{
+    return false;
+}
+
+bool CContainer::locateFile (const std::string& filename, std::filesystem::path& path, uint64_t& offset, uint64_t& length) const
+{
+    return false;
 }
 
 const ITexture* CContainer::readTexture (const std::string& filename) const
@@ -19,9 +49,12 @@ const ITexture* CContainer::readTexture (const std::string& filename) const
     // get the texture's filename (usually .tex)
     std::string texture = "materials/" + filename + ".tex";
 
-    const void* textureContents = this->readFile (texture, nullptr);
+    uint32_t length = 0;
+    std::shared_ptr <const uint8_t[]> textureContents = this->readFile (texture, &length);
+
+    auto* result = new CTexture (std::move (textureContents), length);
 
-    ITexture* result = new CTexture (textureContents);
+    sLog.debug ("Loaded texture ", texture, ": decoding took ", result->getDecodeTime (), "ms, uploading took ", result->getUploadTime (), "ms");
 
 #if !NDEBUG
     glObjectLabel (GL_TEXTURE, result->getTextureID (), -1, texture.c_str ());
@@ -29,7 +62,7 @@ const ITexture* CContainer::readTexture (const std::string& filename) const
 
     return result;
 }
-std::string CContainer::readShader (const std::string& filename) const
+CFileView CContainer::readShader (const std::string& filename) const
 {
     std::filesystem::path shader = filename;
     auto it = shader.begin ();
@@ -42,59 +75,57 @@ std::string CContainer::readShader (const std::string& filename) const
         if (++it != shader.end ())
         {
             std::filesystem::path shaderfile = *it;
+            uint32_t length = 0;
 
-            try
-            {
-                shader = std::filesystem::path ("zcompat") / "scene" / "shaders" / workshopId / shaderfile;
-                // replace the old path with the new one
-                std::string contents = this->readFileAsString (shader);
-
-                sLog.out ("Replaced ", filename, " with compat ", shader);
+            shader = std::filesystem::path ("zcompat") / "scene" / "shaders" / workshopId / shaderfile;
+            // replace the old path with the new one
+            std::shared_ptr <const uint8_t[]> contents = this->tryReadFile (shader, &length);
 
-                return contents;
-            }
-            catch (CAssetLoadException&)
+            if (contents != nullptr)
             {
+                sLog.out ("Replaced ", filename, " with compat ", shader);
 
+                return CFileView (
+                    contents, std::string_view (reinterpret_cast <const char*> (contents.get ()), length)
+                );
             }
         }
     }
 
-    return this->readFileAsString ("shaders/" + filename);
+    return this->readFileAsView ("shaders/" + filename);
 }
 
-std::string CContainer::readVertexShader (const std::string& filename) const
+CFileView CContainer::readVertexShader (const std::string& filename) const
 {
     return this->readShader (filename + ".vert");
 }
 
-std::string CContainer::readFragmentShader (const std::string& filename) const
+CFileView CContainer::readFragmentShader (const std::string& filename) const
 {
     return this->readShader (filename + ".frag");
 }
 
-std::string CContainer::readIncludeShader (const std::string& filename) const
+CFileView CContainer::readIncludeShader (const std::string& filename) const
 {
-    return this->readFileAsString ("shaders/" + filename);
+    return this->readFileAsView ("shaders/" + filename);
 }
 
 std::string CContainer::readFileAsString (const std::string& filename) const
 {
-    uint32_t length = 0;
+    return std::string (this->readFileAsView (filename).view ());
+}
 
-    // read file contents and allocate a buffer for a string
-    const void* contents = this->readFile (std::move (filename), &length);
-    char* buffer = new char [length + 1];
+CFileView CContainer::readFileAsView (const std::string& filename) const
+{
+    uint32_t length = 0;
+    std::shared_ptr <const uint8_t[]> contents = this->readFile (filename, &length);
+    auto text = reinterpret_cast <const char*> (contents.get ());
 
-    // ensure there's a 0 at the end
-    memset (buffer, 0, length + 1);
-    // copy over the data
-    memcpy (buffer, contents, length);
-    // now build the std::string to use
-    std::string result = buffer;
+    // text files might come with a null terminator (like the virtual ones), stop there
+    auto terminator = static_cast <const char*> (memchr (text, '\0', length));
 
-    // free the intermediate buffer used to generate the std::string
-    delete[] buffer;
+    if (terminator != nullptr)
+        length = terminator - text;
 
-    return result;
+    return CFileView (contents, std::string_view (text, length));
 }
\ No newline at end of file
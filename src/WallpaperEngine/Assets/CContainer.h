@@ -1,9 +1,12 @@
 #pragma once
 
 #include "WallpaperEngine/Assets/ITexture.h"
+#include "WallpaperEngine/Assets/CFileView.h"
 
 #include <filesystem>
+#include <memory>
 #include <string>
+#include <vector>
 
 namespace WallpaperEngine::Assets
 {
@@ -17,20 +20,72 @@ namespace WallpaperEngine::Assets
          * Resolves the full path to the specified file in the filesystem
          *
          * @param filename
+         *
+         * @throws CAssetLoadException If the file is not in the filesystem
+         *
          * @return
          */
-        [[nodiscard]] virtual std::filesystem::path resolveRealFile (const std::string& filename) const;
+        [[nodiscard]] std::filesystem::path resolveRealFile (const std::string& filename) const;
+
+        /**
+         * Same as resolveRealFile but does not throw when the file cannot be resolved,
+         * useful for looking up files in multiple containers
+         *
+         * @param filename The file to resolve
+         * @param path The full path to the file in the filesystem
+         *
+         * @return If the file exists in this container and is in the filesystem
+         */
+        virtual bool tryResolveRealFile (const std::string& filename, std::filesystem::path& path) const;
 
         /**
          * Reads the given file from the container and returns it's data
          * Additionally sets a length parameter to return back the file's length
          *
+         * The returned buffer shares ownership of the data, so it's safe to hold onto it
+         * for as long as needed even if the container drops it from it's caches
+         *
          * @param filename The file to read
          * @param length The file's length after it's been read, null for not getting anything back
          *
+         * @throws CAssetLoadException If the file cannot be found in the container
+         *
          * @return
          */
-        [[nodiscard]] virtual const void* readFile (const std::string& filename, uint32_t* length) const = 0;
+        [[nodiscard]] std::shared_ptr <const uint8_t[]> readFile (const std::string& filename, uint32_t* length = nullptr) const;
+
+        /**
+         * Same as readFile but does not throw when the file does not exist,
+         * useful for optional files and for looking up files in multiple containers
+         *
+         * @param filename The file to read
+         * @param length The file's length after it's been read, null for not getting anything back
+         *
+         * @return The file's contents, nullptr if the file does not exist in this container
+         */
+        [[nodiscard]] virtual std::shared_ptr <const uint8_t[]> tryReadFile (const std::string& filename, uint32_t* length = nullptr) const = 0;
+
+        /**
+         * Lists the files in this container if it can be done without going to the disk,
+         * used to build lookup indexes for the containers
+         *
+         * @param files The list to add the filenames to
+         *
+         * @return If the container was able to list it's files
+         */
+        virtual bool listFiles (std::vector <std::string>& files) const;
+
+        /**
+         * Finds where the given file's data is physically stored on disk, used to record asset access traces
+         *
+         * @param filename The file to look for
+         * @param path The file on disk that holds the data
+         * @param offset Where the data starts in the file on disk
+         * @param length The length of the data
+         *
+         * @return If the file's data is stored on disk
+         */
+        virtual bool locateFile (const std::string& filename, std::filesystem::path& path, uint64_t& offset, uint64_t& length) const;
 
         /**
          * Wrapper for readFile, appends the texture extension at the end of the filename
@@ -46,36 +101,36 @@ namespace WallpaperEngine::Assets
          *
          * @param filename
          *
-         * @return The shader code as an string to be used
+         * @return The shader code to be used
          */
-        [[nodiscard]] std::string readShader (const std::string& filename) const;
+        [[nodiscard]] CFileView readShader (const std::string& filename) const;
 
         /**
          * Wrapper for readFile, appends the .vert extension at the end and opens the given shader file
          *
          * @param filename
          *
-         * @return The shader code as an string to be used
+         * @return The shader code to be used
          */
-        [[nodiscard]] std::string readVertexShader (const std::string& filename) const;
+        [[nodiscard]] CFileView readVertexShader (const std::string& filename) const;
 
         /**
          * Wrapper for readFile, appends the .frag extension at the end and opens the given shader file
          *
          * @param filename
          *
-         * @return The shader code as an string to be used
+         * @return The shader code to be used
          */
-        [[nodiscard]] std::string readFragmentShader (const std::string& filename) const;
+        [[nodiscard]] CFileView readFragmentShader (const std::string& filename) const;
 
         /**
          * Wrapper for readFile, appends the .h extension at the end and opens the given shader file
          *
          * @param filename
          *
-         * @return The shader code as an string to be used
+         * @return The shader code to be used
          */
-        [[nodiscard]] std::string readIncludeShader (const std::string& filename) const;
+        [[nodiscard]] CFileView readIncludeShader (const std::string& filename) const;
 
         /**
          * Reads a file as string
@@ -85,5 +140,15 @@ namespace WallpaperEngine::Assets
          * @return The file's contents as string
          */
         [[nodiscard]] std::string readFileAsString (const std::string& filename) const;
+
+        /**
+         * Reads a file as text without copying it's contents, the view stops at the first null character
+         * like the string returned by readFileAsString would
+         *
+         * @param filename
+         *
+         * @return A view over the file's contents
+         */
+        [[nodiscard]] CFileView readFileAsView (const std::string& filename) const;
     };
 }
\ No newline at end of file
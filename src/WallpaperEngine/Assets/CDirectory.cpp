@@ -8,8 +8,12 @@
 
 using namespace WallpaperEngine::Assets;
 
-CDirectory::CDirectory (std::filesystem::path basepath) :
-    m_basepath (std::move(basepath))
+CDirectory::CDirectory (std::filesystem::path basepath, size_t cacheBudget) :
+    m_basepath (std::move(basepath)),
+    m_cacheBudget (cacheBudget),
+    m_cacheSize (0),
+    m_cacheHits (0),
+    m_cacheMisses (0)
 {
     // ensure the specified path exists
     struct stat buffer {};
@@ -24,30 +28,46 @@ CDirectory::CDirectory (std::filesystem::path basepath) :
 CDirectory::~CDirectory ()
 = default;
 
-std::filesystem::path CDirectory::resolveRealFile (const std::string& filename) const
+bool CDirectory::tryResolveRealFile (const std::string& filename, std::filesystem::path& path) const
 {
-    return std::filesystem::path (this->m_basepath) / filename;
+    std::filesystem::path final = std::filesystem::path (this->m_basepath) / filename;
+    struct stat buffer {};
+
+    if (stat (final.c_str (), &buffer) != 0)
+        return false;
+
+    path = final;
+
+    return true;
 }
 
-const void* CDirectory::readFile (const std::string& filename, uint32_t* length) const
+std::shared_ptr <const uint8_t[]> CDirectory::tryReadFile (const std::string& filename, uint32_t* length) const
 {
-    std::filesystem::path final = std::filesystem::path (this->m_basepath) / filename;
+    {
+        std::lock_guard <std::mutex> lock (this->m_cacheMutex);
 
-    // first check the cache, if the file is there already just return the data in there
-    auto it = this->m_cache.find (final);
+        // first check the cache, if the file is there already just return the data in there
+        auto it = this->m_cache.find (filename);
 
-    if (it != this->m_cache.end ())
-    {
-        if (length != nullptr)
-            *length = (*it).second.length;
+        if (it != this->m_cache.end ())
+        {
+            this->m_cacheHits ++;
+            // move the file to the front of the list so it's the last one to be evicted
+            this->m_lru.splice (this->m_lru.begin (), this->m_lru, (*it).second.position);
+
+            if (length != nullptr)
+                *length = (*it).second.file.length;
 
-        return (*it).second.address;
+            return (*it).second.file.address;
+        }
     }
 
+    std::filesystem::path final = std::filesystem::path (this->m_basepath) / filename;
+
     FILE* fp = fopen (final.c_str (), "rb");
 
     if (fp == nullptr)
-        throw CAssetLoadException(filename, "Cannot find file");
+        return nullptr;
 
     // go to the end, get the position and return to the beginning
     fseek (fp, 0, SEEK_END);
@@ -55,16 +75,87 @@ const void* CDirectory::readFile (const std::string& filename, uint32_t* length)
     fseek (fp, 0, SEEK_SET);
 
     // now read the whole file
-    char* contents = new char[size];
+    auto contents = new uint8_t [size];
+    std::shared_ptr <const uint8_t[]> result (contents);
 
-    if (fread (contents, size, 1, fp) != 1)
+    if (size > 0 && fread (contents, size, 1, fp) != 1)
     {
-        delete[] contents;
+        fclose (fp);
         throw CAssetLoadException (filename, "Unexpected error when reading the file");
     }
 
+    fclose (fp);
+
+    this->cacheFile (filename, CFileEntry (result, size));
+
     if (length != nullptr)
         *length = size;
 
-    return contents;
-}
\ No newline at end of file
+    return result;
+}
+
+bool CDirectory::locateFile (const std::string& filename, std::filesystem::path& path, uint64_t& offset, uint64_t& length) const
+{
+    std::filesystem::path final = std::filesystem::path (this->m_basepath) / filename;
+    struct stat buffer {};
+
+    if (stat (final.c_str (), &buffer) != 0 || !S_ISREG (buffer.st_mode))
+        return false;
+
+    path = final;
+    offset = 0;
+    length = buffer.st_size;
+
+    return true;
+}
+
+void CDirectory::cacheFile (const std::string& filename, const CFileEntry& entry) const
+{
+    std::lock_guard <std::mutex> lock (this->m_cacheMutex);
+
+    this->m_cacheMisses ++;
+
+    // files bigger than a quarter of the budget are not worth keeping around
+    // as a single one would flush most of the cache
+    if (entry.length > this->m_cacheBudget / 4)
+        return;
+
+    // another thread might have read the same file already
+    if (this->m_cache.find (filename) != this->m_cache.end ())
+        return;
+
+    // make room for the new file
+    while (this->m_cacheSize + entry.length > this->m_cacheBudget && !this->m_lru.empty ())
+    {
+        auto evicted = this->m_cache.find (this->m_lru.back ());
+
+        this->m_cacheSize -= (*evicted).second.file.length;
+        this->m_cache.erase (evicted);
+        this->m_lru.pop_back ();
+    }
+
+    this->m_lru.push_front (filename);
+    this->m_cache.insert_or_assign (filename, CacheEntry (entry, this->m_lru.begin ()));
+    this->m_cacheSize += entry.length;
+}
+
+uint32_t CDirectory::getCacheHits () const
+{
+    std::lock_guard <std::mutex> lock (this->m_cacheMutex);
+
+    return this->m_cacheHits;
+}
+
+uint32_t CDirectory::getCacheMisses () const
+{
+    std::lock_guard <std::mutex> lock (this->m_cacheMutex);
+
+    return this->m_cacheMisses;
+}
+
+size_t CDirectory::getCacheSize () const
+{
+    std::lock_guard <std::mutex> lock (this->m_cacheMutex);
+
+    return this->m_cacheSize;
+}
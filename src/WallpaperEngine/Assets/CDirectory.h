@@ -2,7 +2,9 @@
 
 #include <string>
 #include <stdexcept>
+#include <list>
 #include <map>
+#include <mutex>
 #include <filesystem>
 
 #include "CContainer.h"
@@ -12,22 +14,80 @@ namespace WallpaperEngine::Assets
 {
     /**
      * Directory container implementation, provides access to background files under a specific directory
+     *
+     * Files read from the directory are kept in a LRU cache limited by a byte budget so repeated reads
+     * (materials, shader includes...) do not hit the disk every time
      */
     class CDirectory : public CContainer
     {
     public:
-        explicit CDirectory (std::filesystem::path basepath);
+        /** Default size of the file cache in bytes */
+        static constexpr size_t DefaultCacheBudget = 16 * 1024 * 1024;
+
+        /**
+         * @param basepath The directory to read files from
+         * @param cacheBudget Maximum amount of bytes the file cache can hold, 0 disables it
+         */
+        explicit CDirectory (std::filesystem::path basepath, size_t cacheBudget = DefaultCacheBudget);
         ~CDirectory ();
 
         /** @inheritdoc */
-        [[nodiscard]] std::filesystem::path resolveRealFile (const std::string& filename) const override;
+        bool tryResolveRealFile (const std::string& filename, std::filesystem::path& path) const override;
+        /** @inheritdoc */
+        [[nodiscard]] std::shared_ptr <const uint8_t[]> tryReadFile (const std::string& filename, uint32_t* length) const override;
         /** @inheritdoc */
-        [[nodiscard]] const void* readFile (const std::string& filename, uint32_t* length) const override;
+        bool locateFile (const std::string& filename, std::filesystem::path& path, uint64_t& offset, uint64_t& length) const override;
+
+        /**
+         * @return The amount of reads served from the cache
+         */
+        [[nodiscard]] uint32_t getCacheHits () const;
+        /**
+         * @return The amount of reads that had to go to the disk
+         */
+        [[nodiscard]] uint32_t getCacheMisses () const;
+        /**
+         * @return The amount of bytes currently held by the cache
+         */
+        [[nodiscard]] size_t getCacheSize () const;
 
     private:
+        /**
+         * Stores the file in the cache, evicting the least recently used files if the budget is exceeded
+         *
+         * @param filename The file's name
+         * @param entry The file's contents
+         */
+        void cacheFile (const std::string& filename, const CFileEntry& entry) const;
+
+        class CacheEntry
+        {
+        public:
+            CacheEntry (CFileEntry file, std::list <std::string>::iterator position) :
+                file (std::move (file)),
+                position (position) { }
+
+            /** The cached file */
+            CFileEntry file;
+            /** Position of this entry in the LRU list */
+            std::list <std::string>::iterator position;
+        };
+
         /** The basepath for the directory */
         std::filesystem::path m_basepath;
         /** File cache to simplify access to data */
-        std::map <std::string, CFileEntry> m_cache;
+        mutable std::map <std::string, CacheEntry> m_cache;
+        /** Cached filenames, from most to least recently used */
+        mutable std::list <std::string> m_lru;
+        /** Maximum amount of bytes the cache can hold */
+        size_t m_cacheBudget;
+        /** Amount of bytes currently in the cache */
+        mutable size_t m_cacheSize;
+        /** Reads served from the cache */
+        mutable uint32_t m_cacheHits;
+        /** Reads that had to go to the disk */
+        mutable uint32_t m_cacheMisses;
+        /** Protects the cache, files can be read from multiple threads */
+        mutable std::mutex m_cacheMutex;
     };
-}
\ No newline at end of file
+}
@@ -1,5 +1,9 @@
 #pragma once
 
+#include <cstdint>
+#include <memory>
+#include <utility>
+
 namespace WallpaperEngine::Assets
 {
     /**
@@ -8,12 +12,12 @@ namespace WallpaperEngine::Assets
     class CFileEntry
     {
     public:
-        CFileEntry (const void* address, uint32_t length) :
-            address (address),
+        CFileEntry (std::shared_ptr <const uint8_t[]> address, uint32_t length) :
+            address (std::move (address)),
             length (length) { }
 
         /** File contents */
-        const void* address;
+        std::shared_ptr <const uint8_t[]> address;
         /** File length */
         uint32_t length;
     };
@@ -0,0 +1,41 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <string_view>
+#include <utility>
+
+namespace WallpaperEngine::Assets
+{
+    /**
+     * Read-only view over a file's contents as returned by the containers, no copies of the data
+     * are made and the underlying buffer is kept alive for as long as the view exists
+     */
+    class CFileView
+    {
+    public:
+        CFileView () = default;
+        CFileView (std::shared_ptr <const uint8_t[]> data, std::string_view view) :
+            m_data (std::move (data)),
+            m_view (view) { }
+
+        /**
+         * @return The file's contents
+         */
+        [[nodiscard]] std::string_view view () const { return this->m_view; }
+        /**
+         * @return Pointer to the start of the file's contents
+         */
+        [[nodiscard]] const char* begin () const { return this->m_view.data (); }
+        /**
+         * @return Pointer past the end of the file's contents
+         */
+        [[nodiscard]] const char* end () const { return this->m_view.data () + this->m_view.size (); }
+
+    private:
+        /** The buffer that holds the file's contents */
+        std::shared_ptr <const uint8_t[]> m_data;
+        /** View over the buffer */
+        std::string_view m_view;
+    };
+}
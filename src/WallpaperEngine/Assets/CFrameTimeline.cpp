@@ -0,0 +1,59 @@
+#include "CFrameTimeline.h"
+
+#include <algorithm>
+
+using namespace WallpaperEngine::Assets;
+
+CFrameTimeline::CFrameTimeline (const ITexture* texture) :
+    m_cursor (0)
+{
+    double end = 0.0;
+
+    this->m_ends.reserve (texture->getFrames ().size ());
+    this->m_frames.reserve (texture->getFrames ().size ());
+
+    for (const auto& cur : texture->getFrames ())
+    {
+        auto width = static_cast <float> (texture->getTextureWidth (cur->frameNumber));
+        auto height = static_cast <float> (texture->getTextureHeight (cur->frameNumber));
+
+        end += cur->frametime;
+
+        this->m_ends.push_back (end);
+        this->m_frames.push_back ({
+            cur->frameNumber,
+            { cur->x / width, cur->y / height },
+            { cur->width1 / width, cur->width2 / width, cur->height2 / height, cur->height1 / height }
+        });
+    }
+}
+
+double CFrameTimeline::getDuration () const
+{
+    return this->m_ends.empty () ? 0.0 : this->m_ends.back ();
+}
+
+const CFrameTimeline::Frame* CFrameTimeline::find (double time) const
+{
+    size_t count = this->m_ends.size ();
+
+    // every pass of the image asks for the same time, and after that usually for the next frame
+    for (size_t index = this->m_cursor; index < count && index <= this->m_cursor + 1; index ++)
+    {
+        if (time <= this->m_ends [index] && (index == 0 || time > this->m_ends [index - 1]))
+        {
+            this->m_cursor = index;
+            return &this->m_frames [index];
+        }
+    }
+
+    // the frame shown is the first one that ends after the given time
+    auto it = std::lower_bound (this->m_ends.begin (), this->m_ends.end (), time);
+
+    if (it == this->m_ends.end ())
+        return nullptr;
+
+    this->m_cursor = std::distance (this->m_ends.begin (), it);
+
+    return &this->m_frames [this->m_cursor];
+}
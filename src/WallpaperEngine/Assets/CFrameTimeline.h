@@ -0,0 +1,58 @@
+#pragma once
+
+#include <glm/vec2.hpp>
+#include <glm/vec4.hpp>
+#include <vector>
+
+#include "ITexture.h"
+
+namespace WallpaperEngine::Assets
+{
+    /**
+     * Precomputed timeline of an animated texture, finds the frame to display
+     * at any given time without walking the whole list of frames
+     */
+    class CFrameTimeline
+    {
+    public:
+        /**
+         * A frame with the values the shaders need already calculated
+         */
+        struct Frame
+        {
+            /** The image the frame is in */
+            uint32_t image;
+            /** Position of the frame in the image (in UV coordinates) */
+            glm::vec2 translation;
+            /** Size and orientation of the frame in the image (in UV coordinates) */
+            glm::vec4 rotation;
+        };
+
+        /**
+         * @param texture The animated texture to build the timeline for
+         */
+        explicit CFrameTimeline (const ITexture* texture);
+
+        /**
+         * @return The length of the full animation
+         */
+        [[nodiscard]] double getDuration () const;
+        /**
+         * Searches the frame that's displayed at the given time, checking the last frame found
+         * and the next one before falling back to a binary search
+         *
+         * @param time The time since the animation started
+         *
+         * @return The frame to display, nullptr if the time is past the end of the animation
+         */
+        [[nodiscard]] const Frame* find (double time) const;
+
+    private:
+        /** The time at which every frame ends */
+        std::vector <double> m_ends;
+        /** The frames of the animation */
+        std::vector <Frame> m_frames;
+        /** The last frame found */
+        mutable size_t m_cursor;
+    };
+}
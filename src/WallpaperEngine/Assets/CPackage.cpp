@@ -6,6 +6,10 @@
 #include <utility>
 #include <sstream>
 
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
 using namespace WallpaperEngine::Assets;
 
 class CPackageEntry
@@ -23,7 +27,11 @@ public:
 
 CPackage::CPackage (std::filesystem::path  path) :
     m_path (std::move(path)),
-    m_contents ()
+    m_contents (),
+    m_mapping (nullptr),
+    m_baseOffset (0),
+    m_mappingLength (0),
+    m_mapped (false)
 {
     this->init ();
 }
@@ -32,30 +40,72 @@ CPackage::~CPackage()
 = default;
 
 
-const void* CPackage::readFile (const std::string& filename, uint32_t* length) const
+std::shared_ptr <const uint8_t[]> CPackage::tryReadFile (const std::string& filename, uint32_t* length) const
 {
     auto it = this->m_contents.find (filename);
 
     if (it == this->m_contents.end ())
-        throw CAssetLoadException(filename, "Cannot find the file in the package");
+        return nullptr;
 
     // set file length if required
     if (length != nullptr)
         *length = (*it).second.length;
 
+    if (!this->m_mapped || (*it).second.length == 0)
+        return (*it).second.address;
+
+    // files are always consumed from start to end once requested, so let the kernel know
+    // to page this range in ahead of the reads instead of faulting it page by page
+    static const uintptr_t pageSize = sysconf (_SC_PAGESIZE);
+
+    auto start = reinterpret_cast <uintptr_t> ((*it).second.address.get ());
+    auto end = start + (*it).second.length;
+    auto alignedStart = start & ~(pageSize - 1);
+
+    madvise (reinterpret_cast <void*> (alignedStart), end - alignedStart, MADV_SEQUENTIAL);
+    madvise (reinterpret_cast <void*> (alignedStart), end - alignedStart, MADV_WILLNEED);
+
+    // the pages are left to the kernel once the data is not used anymore, other readers of the same file
+    // (or the prefetcher that just warmed them up) might still need them
     return (*it).second.address;
 }
 
+bool CPackage::locateFile (const std::string& filename, std::filesystem::path& path, uint64_t& offset, uint64_t& length) const
+{
+    auto it = this->m_contents.find (filename);
+
+    if (it == this->m_contents.end ())
+        return false;
+
+    path = this->m_path;
+    offset = (*it).second.address.get () - this->m_mapping.get ();
+    length = (*it).second.length;
+
+    // the fallback buffer only holds the files' data, not the header
+    if (!this->m_mapped)
+        offset += this->m_baseOffset;
+
+    return true;
+}
+
+bool CPackage::listFiles (std::vector <std::string>& files) const
+{
+    for (const auto& cur : this->m_contents)
+        files.push_back (cur.first);
+
+    return true;
+}
+
 void CPackage::init ()
 {
-    FILE* fp = fopen (this->m_path.c_str (), "rb+");
+    FILE* fp = fopen (this->m_path.c_str (), "rb");
 
     if (fp == nullptr)
         throw CPackageLoadException (this->m_path, std::to_string (errno));
 
     // first validate header
     this->validateHeader (fp);
-    // header is okay, load everything into memory
+    // header is okay, read the index and map the contents
     this->loadFiles (fp);
 
     fclose (fp);
@@ -141,32 +191,73 @@ void CPackage::loadFiles (FILE* fp)
 
         // add the file to the list
         list.emplace_back(filename, offset, length);
-        // only free filename, the file's contents are stored in a map for a later use
+        // only free filename, the file's contents are mapped later
         delete[] filename;
     }
 
     // get current baseOffset, this is where the files start
-    long baseOffset = ftell (fp);
+    long baseOffset = this->m_baseOffset = ftell (fp);
+    const uint8_t* contents = this->mapContents (fp, baseOffset);
+    size_t available = this->m_mappingLength - (this->m_mapped ? baseOffset : 0);
 
     for (const auto& cur : list)
     {
-        long offset = cur.offset + baseOffset;
+        if (static_cast <size_t> (cur.offset) + cur.length > available)
+            sLog.exception ("Cannot read file ", cur.filename, " contents from package ", this->m_path);
 
-        // with all the data we can jump to the offset and read the content
-        if (fseek (fp, offset, SEEK_SET) != 0)
-            sLog.exception ("Cannot find file ", cur.filename, " from package ", this->m_path);
+        // the entry points straight into the mapping and keeps it alive, nothing is copied
+        this->m_contents.insert_or_assign (
+            cur.filename,
+            CFileEntry (std::shared_ptr <const uint8_t[]> (this->m_mapping, contents + cur.offset), cur.length)
+        );
+    }
+}
 
-        // allocate memory for the file's contents and read it from the file
-        char* fileContents = new char [cur.length];
+const uint8_t* CPackage::mapContents (FILE* fp, long baseOffset)
+{
+    struct stat buf {};
 
-        if (fread (fileContents, cur.length, 1, fp) != 1)
-        {
-            delete[] fileContents;
+    if (fstat (fileno (fp), &buf) != 0 || buf.st_size < baseOffset)
+        sLog.exception ("Cannot get file size for package ", this->m_path);
 
-            sLog.exception ("Cannot read file ", cur.filename, " contents from package ", this->m_path);
-        }
+    this->m_mappingLength = buf.st_size;
+
+    // empty packages have nothing to map
+    if (this->m_mappingLength == 0)
+        return nullptr;
+
+    void* mapping = mmap (nullptr, this->m_mappingLength, PROT_READ, MAP_PRIVATE, fileno (fp), 0);
+
+    if (mapping != MAP_FAILED)
+    {
+        size_t length = this->m_mappingLength;
 
-        // add the file to the map
-        this->m_contents.insert_or_assign (cur.filename, CFileEntry (fileContents, cur.length));
+        this->m_mapping = std::shared_ptr <const uint8_t[]> (
+            static_cast <const uint8_t*> (mapping),
+            [length] (const uint8_t* address) { munmap (const_cast <uint8_t*> (address), length); }
+        );
+        this->m_mapped = true;
+
+        // files are requested in no particular order, so prevent the kernel from reading ahead
+        // parts of the package that might never be used, readFile hints the ranges that are needed
+        madvise (mapping, this->m_mappingLength, MADV_RANDOM);
+
+        return this->m_mapping.get () + baseOffset;
     }
-}
\ No newline at end of file
+
+    sLog.debug ("Cannot map package ", this->m_path, " into memory, reading it instead");
+
+    // fallback to a single buffer with the data section of the package
+    this->m_mappingLength -= baseOffset;
+    auto buffer = new uint8_t [this->m_mappingLength];
+
+    this->m_mapping = std::shared_ptr <const uint8_t[]> (buffer);
+
+    if (this->m_mappingLength == 0)
+        return buffer;
+
+    if (fseek (fp, baseOffset, SEEK_SET) != 0 || fread (buffer, this->m_mappingLength, 1, fp) != 1)
+        sLog.exception ("Cannot read contents from package ", this->m_path);
+
+    return buffer;
+}
@@ -16,6 +16,10 @@ namespace WallpaperEngine::Assets
     /**
      * Package container implementation, provides access to background files that are stored
      * inside the WallpaperEngine's pkg format
+     *
+     * The package file is mapped into memory once and only the header index is kept around,
+     * the files' contents are served directly from the mapping so the kernel can page them in
+     * (and out) on demand instead of keeping a private copy of the whole package in the heap
      */
     class CPackage : public CContainer
     {
@@ -23,11 +27,16 @@ namespace WallpaperEngine::Assets
         explicit CPackage (std::filesystem::path path);
         ~CPackage ();
 
-        [[nodiscard]] const void* readFile (const std::string& filename, uint32_t* length) const override;
+        /** @inheritdoc */
+        [[nodiscard]] std::shared_ptr <const uint8_t[]> tryReadFile (const std::string& filename, uint32_t* length) const override;
+        /** @inheritdoc */
+        bool locateFile (const std::string& filename, std::filesystem::path& path, uint64_t& offset, uint64_t& length) const override;
+        /** @inheritdoc */
+        bool listFiles (std::vector <std::string>& files) const override;
 
     protected:
         /**
-         * Loads the current package file and loads all it's contents to memory
+         * Opens the current package file, validates it and maps it's contents
          */
         void init ();
 
@@ -39,12 +48,23 @@ namespace WallpaperEngine::Assets
         void validateHeader (FILE* fp);
 
         /**
-         * Loads the files in the package into memory
+         * Reads the file index of the package and maps the files' contents into memory
          *
          * @param fp The file where to read from
          */
         void loadFiles (FILE* fp);
 
+        /**
+         * Maps the whole package file into memory, falls back to reading the files' data into
+         * a single heap buffer if the filesystem does not support mapping it
+         *
+         * @param fp The file to map
+         * @param baseOffset Where the files' data starts in the package
+         *
+         * @return Pointer to where the files' data starts
+         */
+        const uint8_t* mapContents (FILE* fp, long baseOffset);
+
         /**
          * Reads a size-prefixed string
          *
@@ -67,5 +87,16 @@ namespace WallpaperEngine::Assets
         std::filesystem::path m_path;
         /** Contents of the package file */
         std::map <std::string, CFileEntry> m_contents;
+        /**
+         * The package file's mapping (or the heap buffer if mapping is not possible),
+         * the buffers handed out by readFile share ownership of it
+         */
+        std::shared_ptr <const uint8_t[]> m_mapping;
+        /** Where the files' data starts in the package */
+        long m_baseOffset;
+        /** Size of the mapping in bytes */
+        size_t m_mappingLength;
+        /** Whether m_mapping is an actual mapping or a heap buffer */
+        bool m_mapped;
     };
 }
@@ -1,22 +1,48 @@
 #include "common.h"
 #include "CTexture.h"
+#include "BlockCompression.h"
+#include "PixelConversion.h"
 
+#include "WallpaperEngine/FileSystem/FileSystem.h"
+#include "WallpaperEngine/Threading/CThreadPool.h"
+
+#include <chrono>
+#include <cstdio>
+#include <filesystem>
 #include <string>
 #include <cstring>
+#include <algorithm>
+#include <atomic>
+#include <exception>
+#include <future>
 #include <lz4.h>
+#include <utility>
+#include <unistd.h>
 
 using namespace WallpaperEngine::Assets;
 
-CTexture::CTexture (const void* fileData) :
-    m_resolution ()
+CTexture::CTexture (std::shared_ptr <const uint8_t[]> fileData, uint32_t length, bool streamed) :
+    m_fileData (std::move (fileData)),
+    m_fileLength (length),
+    m_textureID (nullptr),
+    m_resolution (),
+    m_timeline (nullptr),
+    m_atlasTexture (0),
+    m_atlasOffset (),
+    m_atlasRect (),
+    m_internalFormat (GL_RGBA8),
+    m_baseLevel (0),
+    m_transcode (false),
+    m_decodeTime (0.0),
+    m_uploadTime (0.0)
 {
     // ensure the header is parsed
-    this->m_header = parseHeader (static_cast <const char*> (fileData));
-
-    GLint internalFormat;
+    this->m_header = parseHeader (reinterpret_cast <const char*> (this->m_fileData.get ()));
 
     if (this->isAnimated ())
     {
+        this->m_timeline = new CFrameTimeline (this);
+
         this->m_resolution = {
             this->m_header->textureWidth, this->m_header->textureHeight,
             this->m_header->gifWidth, this->m_header->gifHeight
@@ -48,7 +74,7 @@ CTexture::CTexture (const void* fileData) :
 
     if (this->m_header->freeImageFormat != FREE_IMAGE_FORMAT::FIF_UNKNOWN)
     {
-        internalFormat = GL_RGBA8;
+        this->m_internalFormat = GL_RGBA8;
         // set some extra information too as it's used for image sizing
         // this ensures that a_TexCoord uses the full image instead of just part of it
         // TODO: MAYBE IT'S BETTER TO CREATE A TEXTURE OF THE GIVEN SIZE AND COPY OVER WHAT WE READ FROM THE FILE?
@@ -63,22 +89,22 @@ CTexture::CTexture (const void* fileData) :
         switch (this->m_header->format)
         {
         case TextureFormat::DXT5:
-            internalFormat = GL_COMPRESSED_RGBA_S3TC_DXT5_EXT;
+            this->m_internalFormat = GL_COMPRESSED_RGBA_S3TC_DXT5_EXT;
             break;
         case TextureFormat::DXT3:
-            internalFormat = GL_COMPRESSED_RGBA_S3TC_DXT3_EXT;
+            this->m_internalFormat = GL_COMPRESSED_RGBA_S3TC_DXT3_EXT;
             break;
         case TextureFormat::DXT1:
-            internalFormat = GL_COMPRESSED_RGBA_S3TC_DXT1_EXT;
+            this->m_internalFormat = GL_COMPRESSED_RGBA_S3TC_DXT1_EXT;
             break;
         case TextureFormat::ARGB8888:
-            internalFormat = GL_RGBA8;
+            this->m_internalFormat = GL_RGBA8;
             break;
         case TextureFormat::R8:
-            internalFormat = GL_R8;
+            this->m_internalFormat = GL_R8;
             break;
         case TextureFormat::RG88:
-            internalFormat = GL_RG8;
+            this->m_internalFormat = GL_RG8;
             break;
         default:
             delete this->m_header;
@@ -86,11 +112,131 @@ CTexture::CTexture (const void* fileData) :
         }
     }
 
+    // streamed textures are allocated, decoded and uploaded by whoever requested them
+    if (streamed)
+        return;
+
+    this->allocate ();
+
+    // decompress and decode everything on the CPU first
+    this->decode ();
+
+    auto start = std::chrono::steady_clock::now ();
+
+    // and hand it to OpenGL
+    for (const auto& imgCur : this->m_header->images)
+    {
+        for (uint32_t level = this->m_baseLevel; level < imgCur.second.size (); level ++)
+        {
+            uint32_t rowSize, rows;
+            const char* data = this->getUploadData (imgCur.first, level, rowSize, rows);
+
+            this->uploadRows (imgCur.first, level, 0, rows, data);
+        }
+    }
+
+    this->m_uploadTime = std::chrono::duration <double, std::milli> (std::chrono::steady_clock::now () - start).count ();
+
+    this->finishUpload ();
+}
+
+void CTexture::decode ()
+{
+    auto start = std::chrono::steady_clock::now ();
+    std::vector <TextureMipmap*> mipmaps = this->getUsedMipmaps ();
+    FREE_IMAGE_FORMAT format = this->m_header->freeImageFormat;
+
+    // raw pixel data is uploaded straight from the file, only decoding work is worth caching
+    bool cacheable = format != FREE_IMAGE_FORMAT::FIF_UNKNOWN || std::any_of (
+        mipmaps.begin (), mipmaps.end (), [] (const TextureMipmap* cur) { return cur->compression == 1; }
+    );
+
+    // atlased textures only decode the first mipmap, do not let them replace the full entry in the cache
+    if (this->m_atlasTexture != 0 && this->getMipmapCount (0) > 1)
+        cacheable = false;
+    WallpaperEngine::FileSystem::Digest digest {};
+
+    if (cacheable)
+    {
+        // a single pass over the file both names the cache entry and validates it
+        digest = WallpaperEngine::FileSystem::contentDigest ({
+            std::string_view (reinterpret_cast <const char*> (this->m_fileData.get ()), this->m_fileLength)
+        });
+
+        if (this->loadFromDiskCache (digest))
+        {
+            this->m_decodeTime = std::chrono::duration <double, std::milli> (std::chrono::steady_clock::now () - start).count ();
+            return;
+        }
+    }
+
+    bool transcode = this->m_transcode;
+    GLint internalFormat = this->m_internalFormat;
+
+    // not worth the synchronization for a single mipmap
+    if (mipmaps.size () < 2)
+    {
+        for (auto cur : mipmaps)
+        {
+            cur->decode (format);
+
+            if (transcode)
+                cur->encode (internalFormat);
+        }
+    }
+    else
+    {
+        auto& pool = Threading::CThreadPool::get ();
+        std::vector <std::future <void>> tasks;
+
+        tasks.reserve (mipmaps.size ());
+
+        for (auto cur : mipmaps)
+            tasks.push_back (pool.submit ([cur, format, transcode, internalFormat] ()
+            {
+                cur->decode (format);
+
+                if (transcode)
+                    cur->encode (internalFormat);
+            }));
+
+        // every task has to finish before the error is re-thrown, the ones still running write into
+        // the mipmaps that would be freed while unwinding
+        std::exception_ptr error;
+
+        for (auto& cur : tasks)
+        {
+            try
+            {
+                pool.wait (cur);
+            }
+            catch (...)
+            {
+                if (!error)
+                    error = std::current_exception ();
+            }
+        }
+
+        if (error)
+            std::rethrow_exception (error);
+    }
+
+    if (cacheable)
+        this->saveToDiskCache (digest);
+
+    this->m_decodeTime = std::chrono::duration <double, std::milli> (std::chrono::steady_clock::now () - start).count ();
+}
+
+void CTexture::allocate ()
+{
     // allocate texture ids list
     this->m_textureID = new GLuint [this->m_header->imageCount];
     // ask opengl for the correct amount of textures
     glGenTextures (this->m_header->imageCount, this->m_textureID);
 
+    // storage is allocated without data, make sure nullptr is not taken as an offset into a buffer
+    glBindBuffer (GL_PIXEL_UNPACK_BUFFER, 0);
+
     auto imgCur = this->m_header->images.begin ();
     auto imgEnd = this->m_header->images.end ();
 
@@ -100,7 +246,7 @@ CTexture::CTexture (const void* fileData) :
         glBindTexture (GL_TEXTURE_2D, this->m_textureID [index]);
 
         // set mipmap levels
-        glTexParameteri (GL_TEXTURE_2D, GL_TEXTURE_BASE_LEVEL, 0);
+        glTexParameteri (GL_TEXTURE_2D, GL_TEXTURE_BASE_LEVEL, this->m_baseLevel);
         glTexParameteri (GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, this->m_header->mipmapCount - 1);
 
         // setup texture wrapping and filtering
@@ -133,82 +279,301 @@ CTexture::CTexture (const void* fileData) :
 
         for (int32_t level = 0; cur != end; cur ++, level ++)
         {
-            FIBITMAP* bitmap = nullptr;
-            FIBITMAP* converted = nullptr;
-            FIMEMORY* memory = nullptr;
-            void* dataptr = (*cur)->uncompressedData;
-            uint32_t width = (*cur)->width;
-            uint32_t height = (*cur)->height;
-            uint32_t bufferSize = (*cur)->uncompressedSize;
-            GLenum textureFormat = GL_RGBA;
-
-            if (this->m_header->freeImageFormat != FREE_IMAGE_FORMAT::FIF_UNKNOWN)
-            {
-                memory = FreeImage_OpenMemory (reinterpret_cast <BYTE *> ((*cur)->uncompressedData), (*cur)->uncompressedSize);
-
-                // load the image and setup pointers so they can be used
-                bitmap = FreeImage_LoadFromMemory (this->m_header->freeImageFormat, memory);
-                // flip the image vertically
-                FreeImage_FlipVertical (bitmap);
-                // convert to a 32bits bytearray
-                converted = FreeImage_ConvertTo32Bits (bitmap);
-
-                dataptr = FreeImage_GetBits (converted);
-                width = FreeImage_GetWidth (converted);
-                height = FreeImage_GetHeight (converted);
-                bufferSize = FreeImage_GetMemorySize (converted);
-                textureFormat = GL_BGRA;
-            }
-            else
-            {
-                if (this->m_header->format == TextureFormat::R8)
-                {
-                    // red textures are 1-byte-per-pixel, so it's alignment has to be set manually
-                    glPixelStorei (GL_UNPACK_ALIGNMENT, 1);
-                    textureFormat = GL_RED;
-                }
-                else if (this->m_header->format == TextureFormat::RG88)
-                    textureFormat = GL_RG;
-            }
+            uint32_t rowSize, rows, rowHeight;
+
+            // levels below the base level are never sampled
+            if (static_cast <uint32_t> (level) < this->m_baseLevel)
+                continue;
+
+            this->getMipmapLayout (*cur, rowSize, rows, rowHeight);
 
-            switch (internalFormat)
+            switch (this->m_internalFormat)
             {
             case GL_RGBA8:
             case GL_RG8:
             case GL_R8:
                 glTexImage2D (
-                    GL_TEXTURE_2D, level, internalFormat,
-                    width, height, 0,
-                    textureFormat, GL_UNSIGNED_BYTE,
-                    dataptr
+                    GL_TEXTURE_2D, level, this->m_internalFormat,
+                    (*cur)->width, (*cur)->height, 0,
+                    this->getUploadFormat (), GL_UNSIGNED_BYTE,
+                    nullptr
                 );
                 break;
             case GL_COMPRESSED_RGBA_S3TC_DXT1_EXT:
             case GL_COMPRESSED_RGBA_S3TC_DXT3_EXT:
             case GL_COMPRESSED_RGBA_S3TC_DXT5_EXT:
                 glCompressedTexImage2D (
-                    GL_TEXTURE_2D, level, internalFormat,
-                    width, height, 0,
-                    bufferSize, dataptr
+                    GL_TEXTURE_2D, level, this->m_internalFormat,
+                    (*cur)->width, (*cur)->height, 0,
+                    rowSize * rows, nullptr
                 );
                 break;
             default:
                 sLog.exception ("Cannot load texture, unknown format", this->m_header->format);
             }
-
-            // freeimage buffer won't be used anymore, so free memory
-            if (this->m_header->freeImageFormat != FREE_IMAGE_FORMAT::FIF_UNKNOWN)
-            {
-                FreeImage_Unload (bitmap);
-                FreeImage_Unload (converted);
-                FreeImage_CloseMemory (memory);
-            }
         }
     }
 }
 
+void CTexture::getMipmapLayout (const TextureMipmap* mipmap, uint32_t& rowSize, uint32_t& rows, uint32_t& rowHeight) const
+{
+    uint32_t blockSize = 0;
+    uint32_t pixelSize = 4;
+
+    switch (this->m_internalFormat)
+    {
+    case GL_COMPRESSED_RGBA_S3TC_DXT1_EXT:
+        blockSize = 8;
+        break;
+    case GL_COMPRESSED_RGBA_S3TC_DXT3_EXT:
+    case GL_COMPRESSED_RGBA_S3TC_DXT5_EXT:
+        blockSize = 16;
+        break;
+    case GL_RG8:
+        pixelSize = 2;
+        break;
+    case GL_R8:
+        pixelSize = 1;
+        break;
+    default:
+        break;
+    }
+
+    if (blockSize != 0)
+    {
+        // compressed formats are laid out in rows of 4x4 blocks
+        rowSize = std::max (1u, (mipmap->width + 3) / 4) * blockSize;
+        rows = std::max (1u, (mipmap->height + 3) / 4);
+        rowHeight = 4;
+    }
+    else
+    {
+        rowSize = mipmap->width * pixelSize;
+        rows = mipmap->height;
+        rowHeight = 1;
+    }
+}
+
+GLenum CTexture::getUploadFormat () const
+{
+    if (this->m_header->freeImageFormat != FREE_IMAGE_FORMAT::FIF_UNKNOWN)
+        return GL_BGRA;
+    if (this->m_header->format == TextureFormat::R8)
+        return GL_RED;
+    if (this->m_header->format == TextureFormat::RG88)
+        return GL_RG;
+
+    return GL_RGBA;
+}
+
+uint32_t CTexture::getMipmapCount (uint32_t imageIndex) const
+{
+    auto image = this->m_header->images.find (imageIndex);
+
+    if (image == this->m_header->images.end ())
+        return 0;
+
+    return (*image).second.size ();
+}
+
+const char* CTexture::getUploadData (uint32_t imageIndex, uint32_t level, uint32_t& rowSize, uint32_t& rows) const
+{
+    auto image = this->m_header->images.find (imageIndex);
+
+    rowSize = rows = 0;
+
+    if (image == this->m_header->images.end () || level >= (*image).second.size () || level < this->m_baseLevel ||
+        (this->m_atlasTexture != 0 && level > 0))
+        return nullptr;
+
+    const TextureMipmap* mipmap = (*image).second [level];
+    uint32_t rowHeight;
+
+    this->getMipmapLayout (mipmap, rowSize, rows, rowHeight);
+
+    if (mipmap->decodedImage != nullptr)
+    {
+        // freeimage might have padded the rows, so take the layout from the bitmap
+        rowSize = FreeImage_GetPitch (mipmap->decodedImage);
+        rows = std::min (rows, FreeImage_GetHeight (mipmap->decodedImage));
+
+        return reinterpret_cast <const char*> (FreeImage_GetBits (mipmap->decodedImage));
+    }
+
+    // never report more rows than there is data for
+    if (rowSize != 0)
+        rows = std::min (rows, mipmap->uncompressedSize / rowSize);
+
+    return mipmap->uncompressedData;
+}
+
+void CTexture::uploadRows (uint32_t imageIndex, uint32_t level, uint32_t firstRow, uint32_t rowCount, const void* data) const
+{
+    auto image = this->m_header->images.find (imageIndex);
+
+    if (image == this->m_header->images.end () || level >= (*image).second.size () || level < this->m_baseLevel ||
+        (this->m_atlasTexture != 0 && level > 0) || rowCount == 0 || this->m_textureID == nullptr)
+        return;
+
+    const TextureMipmap* mipmap = (*image).second [level];
+    uint32_t rowSize, rows, rowHeight;
+
+    this->getMipmapLayout (mipmap, rowSize, rows, rowHeight);
+
+    if (mipmap->decodedImage != nullptr)
+        rowSize = FreeImage_GetPitch (mipmap->decodedImage);
+
+    uint32_t y = firstRow * rowHeight;
+    uint32_t height = std::min (rowCount * rowHeight, mipmap->height - y);
+    // atlased textures are only a region of the atlas' texture
+    uint32_t x = this->m_atlasOffset.x;
+
+    glBindTexture (GL_TEXTURE_2D, this->m_textureID [std::distance (this->m_header->images.begin (), image)]);
+    // rows are tightly packed, so alignment has to be set manually
+    glPixelStorei (GL_UNPACK_ALIGNMENT, 1);
+    glPixelStorei (GL_UNPACK_ROW_LENGTH, 0);
+
+    switch (this->m_internalFormat)
+    {
+    case GL_RGBA8:
+    case GL_RG8:
+    case GL_R8:
+        glTexSubImage2D (
+            GL_TEXTURE_2D, level, x, y + this->m_atlasOffset.y,
+            mipmap->width, height,
+            this->getUploadFormat (), GL_UNSIGNED_BYTE,
+            data
+        );
+        break;
+    case GL_COMPRESSED_RGBA_S3TC_DXT1_EXT:
+    case GL_COMPRESSED_RGBA_S3TC_DXT3_EXT:
+    case GL_COMPRESSED_RGBA_S3TC_DXT5_EXT:
+        glCompressedTexSubImage2D (
+            GL_TEXTURE_2D, level, 0, y,
+            mipmap->width, height,
+            this->m_internalFormat,
+            rowCount * rowSize, data
+        );
+        break;
+    default:
+        sLog.exception ("Cannot load texture, unknown format", this->m_header->format);
+    }
+
+    glPixelStorei (GL_UNPACK_ALIGNMENT, 4);
+}
+
+size_t CTexture::getMemorySize () const
+{
+    size_t size = 0;
+
+    for (auto cur : this->getUsedMipmaps ())
+    {
+        uint32_t rowSize, rows, rowHeight;
+
+        this->getMipmapLayout (cur, rowSize, rows, rowHeight);
+
+        size += static_cast <size_t> (rowSize) * rows;
+    }
+
+    return size;
+}
+
+void CTexture::setBaseLevel (uint32_t level)
+{
+    uint32_t mipmapCount = this->getMipmapCount (0);
+
+    this->m_baseLevel = mipmapCount == 0 ? 0 : std::min (level, mipmapCount - 1);
+}
+
+uint32_t CTexture::getBaseLevel () const
+{
+    return this->m_baseLevel;
+}
+
+std::vector <CTexture::TextureMipmap*> CTexture::getUsedMipmaps () const
+{
+    std::vector <TextureMipmap*> mipmaps;
+
+    for (const auto& imgCur : this->m_header->images)
+    {
+        // atlases have no mipmaps, so only the first level is used
+        size_t end = this->m_atlasTexture != 0 ? std::min <size_t> (imgCur.second.size (), 1) : imgCur.second.size ();
+
+        for (uint32_t level = this->m_baseLevel; level < end; level ++)
+            mipmaps.push_back (imgCur.second [level]);
+    }
+
+    return mipmaps;
+}
+
+void CTexture::releaseTextures ()
+{
+    if (this->m_textureID == nullptr)
+        return;
+
+    // the atlas' texture is owned by the atlas
+    if (this->m_atlasTexture == 0)
+        glDeleteTextures (this->m_header->imageCount, this->m_textureID);
+
+    delete[] this->m_textureID;
+
+    this->m_textureID = nullptr;
+}
+
+void CTexture::setTranscoding (bool enabled)
+{
+    // only the embedded images are decoded to raw pixels, everything else is uploaded as is
+    if (this->m_header->freeImageFormat == FREE_IMAGE_FORMAT::FIF_UNKNOWN)
+        return;
+
+    this->m_transcode = enabled;
+
+    // the format has to be known before the image is decoded, so jpegs are the only ones known to be opaque
+    if (!enabled)
+        this->m_internalFormat = GL_RGBA8;
+    else if (this->m_header->freeImageFormat == FREE_IMAGE_FORMAT::FIF_JPEG)
+        this->m_internalFormat = GL_COMPRESSED_RGBA_S3TC_DXT1_EXT;
+    else
+        this->m_internalFormat = GL_COMPRESSED_RGBA_S3TC_DXT5_EXT;
+}
+
+bool CTexture::canBeAtlased () const
+{
+    return
+        this->m_internalFormat == GL_RGBA8 &&
+        this->m_header->imageCount == 1 &&
+        !this->isAnimated () &&
+        (this->m_header->flags & TextureFlags::ClampUVs) &&
+        !(this->m_header->flags & TextureFlags::NoInterpolation);
+}
+
+void CTexture::setAtlasRegion (GLuint texture, uint32_t x, uint32_t y, glm::uvec2 atlasSize)
+{
+    this->releaseTextures ();
+
+    this->m_atlasTexture = texture;
+    this->m_atlasOffset = { x, y };
+    this->m_atlasRect = {
+        static_cast <float> (x) / atlasSize.x, static_cast <float> (y) / atlasSize.y,
+        static_cast <float> (this->getTextureWidth ()) / atlasSize.x,
+        static_cast <float> (this->getTextureHeight ()) / atlasSize.y
+    };
+    this->m_baseLevel = 0;
+    this->m_textureID = new GLuint [1] { texture };
+}
+
+void CTexture::finishUpload ()
+{
+    // everything is on the GPU now, only the sizes and frames are needed from here on
+    this->releasePixelData ();
+}
+
 CTexture::~CTexture ()
 {
+    this->releaseTextures ();
+
+    delete this->m_timeline;
+
     if (this->getHeader () == nullptr)
         return;
 
@@ -216,8 +581,227 @@ CTexture::~CTexture ()
     delete this->getHeader ();
 }
 
+void CTexture::releasePixelData ()
+{
+    for (const auto& imgCur : this->m_header->images)
+        for (auto cur : imgCur.second)
+            cur->releaseData ();
+
+    // mipmaps might have been pointing into the file's contents or the cached data
+    this->m_fileData.reset ();
+    this->m_cacheData.reset ();
+}
+
+/**
+ * Header of the decoded texture files stored in the cache
+ */
+struct TextureCacheHeader
+{
+    char magic [8];
+    uint64_t sourceLength;
+    WallpaperEngine::FileSystem::Digest sourceDigest;
+    uint32_t mipmapCount;
+    uint32_t baseLevel;
+};
+
+static const char TEXTURE_CACHE_MAGIC [8] = { 'W', 'P', 'T', 'X', 'C', 'A', 'C', '3' };
+/** Maximum amount of bytes the decoded textures can take on disk */
+static constexpr uintmax_t TEXTURE_CACHE_BUDGET = 1024 * 1024 * 1024;
+
+static std::filesystem::path getTextureCachePath (
+    const WallpaperEngine::FileSystem::Digest& digest, uint32_t baseLevel, bool transcoded
+)
+{
+    // resolved only once, an empty path means there's no cache available
+    static std::filesystem::path directory = [] ()
+    {
+        try
+        {
+            std::filesystem::path result = WallpaperEngine::FileSystem::cacheDirectory ("textures");
+
+            // every background leaves its textures behind, so drop the ones that were not used for the longest
+            WallpaperEngine::FileSystem::pruneCacheDirectory (result, ".texcache", TEXTURE_CACHE_BUDGET);
+
+            return result;
+        }
+        catch (std::exception& e)
+        {
+            sLog.error ("Cannot use texture cache: ", e.what ());
+            return std::filesystem::path ();
+        }
+    } ();
+
+    if (directory.empty ())
+        return directory;
+
+    char name [33];
+    char filename [64];
+
+    // half of the digest is more than enough to tell the files apart, the header has the full one
+    for (int i = 0; i < 16; i ++)
+        snprintf (name + i * 2, 3, "%02x", digest [i]);
+
+    // textures loaded with less detail only store the mipmaps they use
+    snprintf (filename, sizeof (filename), "%s-%u%s.texcache", name, baseLevel, transcoded ? "-bc" : "");
+
+    return directory / filename;
+}
+
+bool CTexture::loadFromDiskCache (const WallpaperEngine::FileSystem::Digest& digest)
+{
+    std::filesystem::path path = getTextureCachePath (digest, this->m_baseLevel, this->m_transcode);
+
+    if (path.empty ())
+        return false;
+
+    FILE* fp = fopen (path.c_str (), "rb");
+
+    if (fp == nullptr)
+        return false;
+
+    fseek (fp, 0, SEEK_END);
+    long size = ftell (fp);
+    fseek (fp, 0, SEEK_SET);
+
+    std::vector <TextureMipmap*> mipmaps = this->getUsedMipmaps ();
+
+    TextureCacheHeader header {};
+    auto* contents = new uint8_t [size > 0 ? size : 1];
+    std::shared_ptr <const uint8_t[]> data (contents);
+
+    bool valid =
+        size >= static_cast <long> (sizeof (TextureCacheHeader)) &&
+        fread (contents, size, 1, fp) == 1;
+
+    fclose (fp);
+
+    if (valid)
+    {
+        memcpy (&header, contents, sizeof (header));
+
+        // make sure the file is for the exact same texture
+        valid =
+            memcmp (header.magic, TEXTURE_CACHE_MAGIC, sizeof (TEXTURE_CACHE_MAGIC)) == 0 &&
+            header.sourceLength == this->m_fileLength &&
+            header.sourceDigest == digest &&
+            header.mipmapCount == mipmaps.size () &&
+            header.baseLevel == this->m_baseLevel;
+    }
+
+    size_t offset = sizeof (TextureCacheHeader);
+    std::vector <std::pair <size_t, uint32_t>> ranges;
+
+    for (size_t i = 0; valid && i < mipmaps.size (); i ++)
+    {
+        uint32_t length;
+
+        if (offset + sizeof (length) > static_cast <size_t> (size))
+        {
+            valid = false;
+            break;
+        }
+
+        memcpy (&length, contents + offset, sizeof (length));
+        offset += sizeof (length);
+
+        if (offset + length > static_cast <size_t> (size))
+        {
+            valid = false;
+            break;
+        }
+
+        ranges.emplace_back (offset, length);
+        offset += length;
+    }
+
+    if (!valid)
+    {
+        sLog.debug ("Ignoring invalid texture cache file ", path);
+        return false;
+    }
+
+    // the cached data is already in the format it's uploaded in
+    for (size_t i = 0; i < mipmaps.size (); i ++)
+    {
+        mipmaps [i]->uncompressedData = reinterpret_cast <const char*> (contents + ranges [i].first);
+        mipmaps [i]->uncompressedSize = ranges [i].second;
+    }
+
+    this->m_cacheData = std::move (data);
+
+    WallpaperEngine::FileSystem::touchCacheFile (path);
+
+    return true;
+}
+
+void CTexture::saveToDiskCache (const WallpaperEngine::FileSystem::Digest& digest) const
+{
+    std::filesystem::path path = getTextureCachePath (digest, this->m_baseLevel, this->m_transcode);
+
+    if (path.empty ())
+        return;
+
+    // write to a temporary file first so other instances never see a partial file
+    static std::atomic <uint32_t> sequence = 0;
+    std::filesystem::path temporary = path;
+
+    temporary += "." + std::to_string (getpid ()) + "." + std::to_string (sequence ++) + ".tmp";
+
+    FILE* fp = fopen (temporary.c_str (), "wb");
+
+    if (fp == nullptr)
+        return;
+
+    TextureCacheHeader header {};
+
+    memcpy (header.magic, TEXTURE_CACHE_MAGIC, sizeof (TEXTURE_CACHE_MAGIC));
+    header.sourceLength = this->m_fileLength;
+    header.sourceDigest = digest;
+    header.mipmapCount = this->getUsedMipmaps ().size ();
+    header.baseLevel = this->m_baseLevel;
+
+    bool success = fwrite (&header, sizeof (header), 1, fp) == 1;
+
+    for (const auto& imgCur : this->m_header->images)
+    {
+        for (uint32_t level = this->m_baseLevel; success && level < imgCur.second.size (); level ++)
+        {
+            uint32_t rowSize, rows;
+            const char* data = this->getUploadData (imgCur.first, level, rowSize, rows);
+            uint32_t length = data == nullptr ? 0 : rowSize * rows;
+
+            success = fwrite (&length, sizeof (length), 1, fp) == 1 &&
+                (length == 0 || fwrite (data, length, 1, fp) == 1);
+        }
+    }
+
+    success = fclose (fp) == 0 && success;
+
+    std::error_code ec;
+
+    if (success)
+        std::filesystem::rename (temporary, path, ec);
+
+    if (!success || ec)
+        std::filesystem::remove (temporary, ec);
+}
+
+double CTexture::getDecodeTime () const
+{
+    return this->m_decodeTime;
+}
+
+double CTexture::getUploadTime () const
+{
+    return this->m_uploadTime;
+}
+
 const GLuint CTexture::getTextureID (uint32_t imageIndex) const
 {
+    // the textures were already freed
+    if (this->m_textureID == nullptr)
+        return 0;
+
     // ensure we do not go out of bounds
     if (imageIndex > this->m_header->imageCount)
         return this->m_textureID [0];
@@ -276,6 +860,21 @@ const std::vector<ITexture::TextureFrame*>& CTexture::getFrames () const
     return this->getHeader ()->frames;
 }
 
+const CFrameTimeline* CTexture::getFrameTimeline () const
+{
+    return this->m_timeline;
+}
+
+const glm::vec4* CTexture::getAtlasRect () const
+{
+    return this->m_atlasTexture != 0 ? &this->m_atlasRect : nullptr;
+}
+
+bool CTexture::isAtlased () const
+{
+    return this->m_atlasTexture != 0;
+}
+
 const bool CTexture::isAnimated () const
 {
     return this->getHeader ()->isAnimated ();
@@ -286,23 +885,94 @@ CTexture::TextureMipmap::TextureMipmap ()
 
 CTexture::TextureMipmap::~TextureMipmap ()
 {
-    if (this->compression == 1)
-        delete this->compressedData;
+    this->releaseData ();
+}
+
+void CTexture::TextureMipmap::releaseData ()
+{
+    delete[] this->decompressionBuffer;
+
+    if (this->decodedImage != nullptr)
+        FreeImage_Unload (this->decodedImage);
+
+    this->compressedData = nullptr;
+    this->uncompressedData = nullptr;
+    this->decompressionBuffer = nullptr;
+    this->decodedImage = nullptr;
+}
+
+void CTexture::TextureMipmap::decode (FREE_IMAGE_FORMAT format)
+{
+    this->decompressData ();
+
+    if (format == FREE_IMAGE_FORMAT::FIF_UNKNOWN)
+        return;
+
+    FIMEMORY* memory = FreeImage_OpenMemory (reinterpret_cast <BYTE *> (const_cast <char*> (this->uncompressedData)), this->uncompressedSize);
+
+    // load the image and setup pointers so they can be used
+    FIBITMAP* bitmap = FreeImage_LoadFromMemory (format, memory);
+
+    FreeImage_CloseMemory (memory);
+
+    if (bitmap == nullptr)
+        sLog.exception ("Cannot decode texture image data");
 
-    delete this->uncompressedData;
+    // flip the image vertically and convert it to 32 bits in one go
+    this->decodedImage = PixelConversion::convertFlipped (bitmap);
+
+    // palettes and high bit depth images go through freeimage's own conversion
+    if (this->decodedImage == nullptr)
+    {
+        FreeImage_FlipVertical (bitmap);
+        this->decodedImage = FreeImage_ConvertTo32Bits (bitmap);
+    }
+
+    FreeImage_Unload (bitmap);
+}
+
+void CTexture::TextureMipmap::encode (GLint internalFormat)
+{
+    if (this->decodedImage == nullptr)
+        return;
+
+    if (FreeImage_GetWidth (this->decodedImage) != this->width || FreeImage_GetHeight (this->decodedImage) != this->height)
+        sLog.exception ("Cannot compress texture image, the decoded image doesn't match the mipmap's size");
+
+    bool opaque = internalFormat == GL_COMPRESSED_RGBA_S3TC_DXT1_EXT;
+    size_t size = BlockCompression::getCompressedSize (this->width, this->height, opaque ? 8 : 16);
+    auto* buffer = new char [size];
+    const auto* pixels = FreeImage_GetBits (this->decodedImage);
+    uint32_t pitch = FreeImage_GetPitch (this->decodedImage);
+
+    if (opaque)
+        BlockCompression::encodeBC1 (pixels, pitch, this->width, this->height, reinterpret_cast <uint8_t*> (buffer));
+    else
+        BlockCompression::encodeBC3 (pixels, pitch, this->width, this->height, reinterpret_cast <uint8_t*> (buffer));
+
+    // the blocks replace both the decompressed file and the decoded image
+    delete[] this->decompressionBuffer;
+    FreeImage_Unload (this->decodedImage);
+
+    this->decodedImage = nullptr;
+    this->decompressionBuffer = buffer;
+    this->uncompressedData = buffer;
+    this->uncompressedSize = size;
 }
 
 void CTexture::TextureMipmap::decompressData ()
 {
     if (this->compression == 1)
     {
-        this->uncompressedData = new char [this->uncompressedSize];
+        this->decompressionBuffer = new char [this->uncompressedSize];
 
         int result = LZ4_decompress_safe (
-            this->compressedData, this->uncompressedData,
+            this->compressedData, this->decompressionBuffer,
             this->compressedSize, this->uncompressedSize
         );
 
+        this->uncompressedData = this->decompressionBuffer;
+
         if (!result)
             sLog.exception ("Cannot decompress texture data, LZ4_decompress_safe returned an error");
     }
@@ -526,21 +1196,17 @@ CTexture::TextureMipmap* CTexture::parseMipmap (TextureHeader* header, const cha
         mipmap->uncompressedSize = mipmap->compressedSize;
     }
 
-    mipmap->uncompressedData = new char [mipmap->uncompressedSize];
-
     if (mipmap->compression == 1)
     {
-        mipmap->compressedData = new char [mipmap->compressedSize];
-
-        memcpy (mipmap->compressedData, fileData, mipmap->compressedSize);
-
-        mipmap->decompressData ();
+        // decompression reads straight from the file buffer
+        mipmap->compressedData = fileData;
         // advance to the end of the mipmap
         fileData += mipmap->compressedSize;
     }
     else
     {
-        memcpy (mipmap->uncompressedData, fileData, mipmap->uncompressedSize);
+        // uncompressed mipmaps are uploaded straight from the file buffer
+        mipmap->uncompressedData = fileData;
         // advance to the end of the mipmap
         fileData += mipmap->uncompressedSize;
     }
@@ -1,11 +1,15 @@
 #pragma once
 
 #include "ITexture.h"
+#include "CFrameTimeline.h"
+#include "WallpaperEngine/FileSystem/FileSystem.h"
 
 #include <FreeImage.h>
 #include <GL/glew.h>
+#include <glm/vec2.hpp>
 #include <glm/vec4.hpp>
 #include <map>
+#include <memory>
 #include <stdexcept>
 #include <string>
 #include <vector>
@@ -58,14 +62,36 @@ namespace WallpaperEngine::Assets
             uint32_t uncompressedSize = 0;
             /** Compress size of the mipmap */
             uint32_t compressedSize = 0;
-            /** Pointer to the compressed data */
-            char* compressedData = nullptr;
-            /** Pointer to the uncompressed data */
-            char* uncompressedData = nullptr;
+            /** Pointer to the compressed data (inside the texture file's contents) */
+            const char* compressedData = nullptr;
+            /** Pointer to the uncompressed data (inside the texture file's contents or the decompression buffer) */
+            const char* uncompressedData = nullptr;
+            /** Buffer the compressed data is decompressed into, owned by the mipmap */
+            char* decompressionBuffer = nullptr;
+            /** The image decoded by FreeImage (only for textures that embed an image file) */
+            FIBITMAP* decodedImage = nullptr;
             /**
              * Performs actual decompression of the compressed data
              */
             void decompressData ();
+            /**
+             * Decompresses the mipmap and, if the texture embeds an image file,
+             * decodes it so it's ready to be uploaded. Safe to call from worker threads
+             *
+             * @param format The image format embedded in the texture, FIF_UNKNOWN for raw pixel data
+             */
+            void decode (FREE_IMAGE_FORMAT format);
+            /**
+             * Compresses the decoded image into the given block format, replacing the decoded image.
+             * Safe to call from worker threads
+             *
+             * @param internalFormat GL_COMPRESSED_RGBA_S3TC_DXT1_EXT or GL_COMPRESSED_RGBA_S3TC_DXT5_EXT
+             */
+            void encode (GLint internalFormat);
+            /**
+             * Frees the compressed and uncompressed data
+             */
+            void releaseData ();
         };
 
         /**
@@ -112,7 +138,12 @@ namespace WallpaperEngine::Assets
         };
 
     public:
-        explicit CTexture (const void* fileData);
+        /**
+         * @param fileData The texture file's contents, kept alive for as long as the pixel data is
+         * @param length The length of the texture file
+         * @param streamed Only parse the texture, allocating, decoding and uploading is left to the caller
+         */
+        CTexture (std::shared_ptr <const uint8_t[]> fileData, uint32_t length, bool streamed = false);
         ~CTexture ();
 
         /** @inheritdoc */
@@ -134,8 +165,105 @@ namespace WallpaperEngine::Assets
         /** @inheritdoc */
         [[nodiscard]] const std::vector<TextureFrame*>& getFrames () const override;
         /** @inheritdoc */
+        [[nodiscard]] const CFrameTimeline* getFrameTimeline () const override;
+        /** @inheritdoc */
+        [[nodiscard]] const glm::vec4* getAtlasRect () const override;
+        /** @inheritdoc */
+        [[nodiscard]] bool isAtlased () const override;
+        /** @inheritdoc */
         [[nodiscard]] const bool isAnimated () const override;
 
+        /**
+         * @return The time spent decompressing and decoding the texture on the CPU (in milliseconds)
+         */
+        [[nodiscard]] double getDecodeTime () const;
+        /**
+         * @return The time spent uploading the texture to the GPU (in milliseconds)
+         */
+        [[nodiscard]] double getUploadTime () const;
+
+        /**
+         * Decompresses and decodes all the mipmaps, spreading them across the thread pool.
+         * Doesn't touch OpenGL so it's safe to call from worker threads
+         */
+        void decode ();
+        /**
+         * @param imageIndex The image to get the mipmap count for
+         *
+         * @return The number of mipmaps the image has
+         */
+        [[nodiscard]] uint32_t getMipmapCount (uint32_t imageIndex) const;
+        /**
+         * Returns the decoded data of a mipmap as rows ready to be uploaded
+         * (pixel rows for uncompressed formats, rows of 4x4 blocks for compressed ones)
+         *
+         * @param imageIndex The image to get the data for
+         * @param level The mipmap level to get the data for
+         * @param rowSize Output for the size of every row in bytes
+         * @param rows Output for the amount of rows
+         *
+         * @return The decoded data, nullptr if it's not available
+         */
+        [[nodiscard]] const char* getUploadData (uint32_t imageIndex, uint32_t level, uint32_t& rowSize, uint32_t& rows) const;
+        /**
+         * Uploads the given rows of a mipmap to the GPU
+         *
+         * @param imageIndex The image to upload to
+         * @param level The mipmap level to upload to
+         * @param firstRow The first row to upload
+         * @param rowCount The amount of rows to upload
+         * @param data The row data (or offset into the bound GL_PIXEL_UNPACK_BUFFER)
+         */
+        void uploadRows (uint32_t imageIndex, uint32_t level, uint32_t firstRow, uint32_t rowCount, const void* data) const;
+        /**
+         * @return The amount of GPU memory the texture uses (in bytes)
+         */
+        [[nodiscard]] size_t getMemorySize () const;
+        /**
+         * Sets the first mipmap level that will be used, the levels before it are not decoded
+         * nor uploaded. Must be called before the texture is allocated and decoded
+         *
+         * @param level The first mipmap level to use
+         */
+        void setBaseLevel (uint32_t level);
+        /**
+         * @return The first mipmap level in use
+         */
+        [[nodiscard]] uint32_t getBaseLevel () const;
+        /**
+         * Compresses the images embedded in the texture (PNG, JPEG...) to DXT1/DXT5 once they're decoded,
+         * so they take less GPU memory. Must be called before the texture is allocated and decoded
+         *
+         * @param enabled Whether the images have to be compressed
+         */
+        void setTranscoding (bool enabled);
+        /**
+         * Creates the OpenGL textures and allocates the storage for every mipmap in use
+         */
+        void allocate ();
+        /**
+         * Frees the OpenGL textures, the texture's information is still available afterwards
+         */
+        void releaseTextures ();
+        /**
+         * @return If the texture can be placed in a texture atlas (single, filtered RGBA8 image that is not repeated)
+         */
+        [[nodiscard]] bool canBeAtlased () const;
+        /**
+         * Places the texture inside an atlas instead of its own OpenGL texture, only the first mipmap is used.
+         * Must be called instead of allocate
+         *
+         * @param texture The atlas' texture, the texture doesn't take ownership of it
+         * @param x Horizontal position of the texture inside the atlas (in pixels)
+         * @param y Vertical position of the texture inside the atlas (in pixels)
+         * @param atlasSize The size of the atlas (in pixels)
+         */
+        void setAtlasRegion (GLuint texture, uint32_t x, uint32_t y, glm::uvec2 atlasSize);
+        /**
+         * Signals that every mipmap was uploaded, releasing the pixel data if it's not needed anymore
+         */
+        void finishUpload ();
+
     private:
         /**
          * @return The texture header
@@ -164,12 +292,70 @@ namespace WallpaperEngine::Assets
          * @return
          */
         static TextureMipmap* parseMipmap (TextureHeader* header, const char** fileData);
+        /**
+         * Frees the pixel data of all the mipmaps, only the sizes are kept
+         */
+        void releasePixelData ();
+        /**
+         * Tries to load the decoded mipmaps from the on-disk texture cache
+         *
+         * @param digest The digest of the texture file's contents
+         * @return If the decoded mipmaps were loaded
+         */
+        bool loadFromDiskCache (const FileSystem::Digest& digest);
+        /**
+         * Stores the decoded mipmaps in the on-disk texture cache so the next run doesn't have to decode them
+         *
+         * @param digest The digest of the texture file's contents
+         */
+        void saveToDiskCache (const FileSystem::Digest& digest) const;
+        /**
+         * @return The mipmaps that are decoded and uploaded (from the base level onwards)
+         */
+        [[nodiscard]] std::vector <TextureMipmap*> getUsedMipmaps () const;
+        /**
+         * Calculates the layout of the given mipmap's data
+         *
+         * @param mipmap The mipmap to get the layout for
+         * @param rowSize Output for the size of every row in bytes
+         * @param rows Output for the amount of rows
+         * @param rowHeight Output for the amount of pixels every row covers
+         */
+        void getMipmapLayout (const TextureMipmap* mipmap, uint32_t& rowSize, uint32_t& rows, uint32_t& rowHeight) const;
+        /**
+         * @return The pixel format the data is uploaded in
+         */
+        [[nodiscard]] GLenum getUploadFormat () const;
 
+        /** The texture file's contents, mipmaps point into it */
+        std::shared_ptr <const uint8_t[]> m_fileData;
+        /** The length of the texture file */
+        uint32_t m_fileLength;
+        /** Decoded mipmaps loaded from the on-disk texture cache, mipmaps point into it */
+        std::shared_ptr <const uint8_t[]> m_cacheData;
         /** The texture header */
         TextureHeader* m_header;
         /** OpenGL's texture ID */
         GLuint* m_textureID;
         /** Resolution vector of the texture */
         glm::vec4 m_resolution;
+        /** Timeline of the frames, only for animated textures */
+        CFrameTimeline* m_timeline;
+        /** The atlas' texture the texture is stored in, 0 if it has its own texture */
+        GLuint m_atlasTexture;
+        /** Position of the texture inside the atlas (in pixels) */
+        glm::uvec2 m_atlasOffset;
+        /** Position and size of the texture inside the atlas (in texture coordinates) */
+        glm::vec4 m_atlasRect;
+        /** Internal format to use for uploading the texture */
+        GLint m_internalFormat;
+        /** The first mipmap level in use */
+        uint32_t m_baseLevel;
+        /** Whether the embedded images are compressed after decoding them */
+        bool m_transcode;
+        /** Time spent decoding the texture (in milliseconds) */
+        double m_decodeTime;
+        /** Time spent uploading the texture (in milliseconds) */
+        double m_uploadTime;
     };
 }
\ No newline at end of file
@@ -1,36 +1,44 @@
 #include <memory.h>
 
 #include "CVirtualContainer.h"
-#include "CAssetLoadException.h"
 
 using namespace WallpaperEngine::Assets;
 
-void CVirtualContainer::add (const std::string& filename, void* contents, uint32_t length)
+void CVirtualContainer::add (const std::string& filename, std::shared_ptr <const uint8_t[]> contents, uint32_t length)
 {
     this->m_virtualFiles.insert (
-        std::make_pair (filename, CFileEntry (contents, length))
+        std::make_pair (filename, CFileEntry (std::move (contents), length))
     );
 }
 
 void CVirtualContainer::add (const std::string& filename, const std::string& contents)
 {
-    char* copy = new char [contents.length () + 1];
+    auto copy = new uint8_t [contents.length () + 1];
 
     // copy the text AND the \0
     memcpy (copy, contents.c_str (), contents.length () + 1);
 
     // finally add to the container
-    this->add (filename, copy, contents.length () + 1);
+    this->add (filename, std::shared_ptr <const uint8_t[]> (copy), contents.length () + 1);
 }
 
-const void* CVirtualContainer::readFile (const std::string& filename, uint32_t* length) const
+std::shared_ptr <const uint8_t[]> CVirtualContainer::tryReadFile (const std::string& filename, uint32_t* length) const
 {
     auto cur = this->m_virtualFiles.find (filename);
 
     if (cur == this->m_virtualFiles.end ())
-        throw CAssetLoadException (filename, "Cannot find file in the virtual container");
+        return nullptr;
 
-    *length = (*cur).second.length;
+    if (length != nullptr)
+        *length = (*cur).second.length;
 
     return (*cur).second.address;
+}
+
+bool CVirtualContainer::listFiles (std::vector <std::string>& files) const
+{
+    for (const auto& cur : this->m_virtualFiles)
+        files.push_back (cur.first);
+
+    return true;
 }
\ No newline at end of file
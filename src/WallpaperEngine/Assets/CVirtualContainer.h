@@ -24,7 +24,7 @@ namespace WallpaperEngine::Assets
          * @param contents
          * @param length
          */
-        void add (const std::string& filename, void* contents, uint32_t length);
+        void add (const std::string& filename, std::shared_ptr <const uint8_t[]> contents, uint32_t length);
 
         /**
          * Adds a new file to the virtual container
@@ -34,7 +34,9 @@ namespace WallpaperEngine::Assets
          */
         void add (const std::string& filename, const std::string& contents);
         /** @inheritdoc */
-        const void* readFile (const std::string& filename, uint32_t* length) const override;
+        [[nodiscard]] std::shared_ptr <const uint8_t[]> tryReadFile (const std::string& filename, uint32_t* length) const override;
+        /** @inheritdoc */
+        bool listFiles (std::vector <std::string>& files) const override;
 
     private:
         /** The recorded files in this virtual container */
@@ -6,6 +6,8 @@
 
 namespace WallpaperEngine::Assets
 {
+    class CFrameTimeline;
+
     /**
      * Base interface that describes the minimum information required for a texture
      * to be displayed by the engine
@@ -106,6 +108,18 @@ namespace WallpaperEngine::Assets
          * @return The list of frames this texture has
          */
         [[nodiscard]] virtual const std::vector<TextureFrame*>& getFrames () const = 0;
+        /**
+         * @return The precomputed timeline of the frames, nullptr if the texture is not animated
+         */
+        [[nodiscard]] virtual const CFrameTimeline* getFrameTimeline () const = 0;
+        /**
+         * @return Position (xy) and size (zw) of the texture inside its atlas, nullptr if it's not in an atlas
+         */
+        [[nodiscard]] virtual const glm::vec4* getAtlasRect () const = 0;
+        /**
+         * @return If the texture lives in an atlas once it's loaded, known before the texture is ready
+         */
+        [[nodiscard]] virtual bool isAtlased () const = 0;
         /**
          * @return The texture's resolution vector
          */
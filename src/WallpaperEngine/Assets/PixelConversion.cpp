@@ -0,0 +1,125 @@
+#include "PixelConversion.h"
+
+#include <cstring>
+
+#if PIXEL_CONVERSION_X86
+#include <immintrin.h>
+#endif /* PIXEL_CONVERSION_X86 */
+
+using namespace WallpaperEngine::Assets;
+
+void PixelConversion::expandRowScalar (const uint8_t* source, uint8_t* destination, uint32_t pixels)
+{
+    for (uint32_t i = 0; i < pixels; i ++, source += 3, destination += 4)
+    {
+        destination [0] = source [0];
+        destination [1] = source [1];
+        destination [2] = source [2];
+        destination [3] = 0xFF;
+    }
+}
+
+#if PIXEL_CONVERSION_X86
+/**
+ * Expands 4 pixels per iteration, every load reads 16 bytes so the last pixels are left to the scalar version
+ */
+__attribute__ ((target ("ssse3")))
+void PixelConversion::expandRowSSSE3 (const uint8_t* source, uint8_t* destination, uint32_t pixels)
+{
+    const __m128i shuffle = _mm_setr_epi8 (0, 1, 2, -1, 3, 4, 5, -1, 6, 7, 8, -1, 9, 10, 11, -1);
+    const __m128i alpha = _mm_set1_epi32 (static_cast <int> (0xFF000000));
+    uint32_t i = 0;
+
+    for (; i + 6 <= pixels; i += 4)
+    {
+        __m128i in = _mm_loadu_si128 (reinterpret_cast <const __m128i*> (source + i * 3));
+        __m128i out = _mm_or_si128 (_mm_shuffle_epi8 (in, shuffle), alpha);
+
+        _mm_storeu_si128 (reinterpret_cast <__m128i*> (destination + i * 4), out);
+    }
+
+    expandRowScalar (source + i * 3, destination + i * 4, pixels - i);
+}
+
+/**
+ * Expands 8 pixels per iteration, every lane takes 4 of them as shuffles do not cross lanes
+ */
+__attribute__ ((target ("avx2")))
+void PixelConversion::expandRowAVX2 (const uint8_t* source, uint8_t* destination, uint32_t pixels)
+{
+    const __m256i shuffle = _mm256_setr_epi8 (
+        0, 1, 2, -1, 3, 4, 5, -1, 6, 7, 8, -1, 9, 10, 11, -1,
+        0, 1, 2, -1, 3, 4, 5, -1, 6, 7, 8, -1, 9, 10, 11, -1
+    );
+    const __m256i alpha = _mm256_set1_epi32 (static_cast <int> (0xFF000000));
+    uint32_t i = 0;
+
+    for (; i + 10 <= pixels; i += 8)
+    {
+        __m256i in = _mm256_inserti128_si256 (
+            _mm256_castsi128_si256 (_mm_loadu_si128 (reinterpret_cast <const __m128i*> (source + i * 3))),
+            _mm_loadu_si128 (reinterpret_cast <const __m128i*> (source + i * 3 + 12)),
+            1
+        );
+        __m256i out = _mm256_or_si256 (_mm256_shuffle_epi8 (in, shuffle), alpha);
+
+        _mm256_storeu_si256 (reinterpret_cast <__m256i*> (destination + i * 4), out);
+    }
+
+    expandRowScalar (source + i * 3, destination + i * 4, pixels - i);
+}
+#endif /* PIXEL_CONVERSION_X86 */
+
+void PixelConversion::expandRow (const uint8_t* source, uint8_t* destination, uint32_t pixels)
+{
+    using ExpandFunction = void (*) (const uint8_t*, uint8_t*, uint32_t);
+
+    // pick the best version for this CPU only once
+    static const ExpandFunction expand = [] () -> ExpandFunction
+    {
+#if PIXEL_CONVERSION_X86
+        if (__builtin_cpu_supports ("avx2"))
+            return expandRowAVX2;
+        if (__builtin_cpu_supports ("ssse3"))
+            return expandRowSSSE3;
+#endif /* PIXEL_CONVERSION_X86 */
+
+        return expandRowScalar;
+    } ();
+
+    expand (source, destination, pixels);
+}
+
+FIBITMAP* PixelConversion::convertFlipped (FIBITMAP* bitmap)
+{
+    uint32_t bpp = FreeImage_GetBPP (bitmap);
+
+    if (FreeImage_GetImageType (bitmap) != FIT_BITMAP || (bpp != 24 && bpp != 32))
+        return nullptr;
+
+    uint32_t width = FreeImage_GetWidth (bitmap);
+    uint32_t height = FreeImage_GetHeight (bitmap);
+    FIBITMAP* result = FreeImage_Allocate (width, height, 32);
+
+    if (result == nullptr)
+        return nullptr;
+
+    uint32_t sourcePitch = FreeImage_GetPitch (bitmap);
+    uint32_t destinationPitch = FreeImage_GetPitch (result);
+    const uint8_t* source = FreeImage_GetBits (bitmap);
+    uint8_t* destination = FreeImage_GetBits (result);
+
+    // write the rows in reverse order, that's the flip
+    for (uint32_t y = 0; y < height; y ++)
+    {
+        const uint8_t* sourceRow = source + static_cast <size_t> (height - 1 - y) * sourcePitch;
+        uint8_t* destinationRow = destination + static_cast <size_t> (y) * destinationPitch;
+
+        if (bpp == 32)
+            memcpy (destinationRow, sourceRow, static_cast <size_t> (width) * 4);
+        else
+            expandRow (sourceRow, destinationRow, width);
+    }
+
+    return result;
+}
@@ -0,0 +1,44 @@
+#pragma once
+
+#include <FreeImage.h>
+#include <cstdint>
+
+namespace WallpaperEngine::Assets::PixelConversion
+{
+    /**
+     * Expands a row of 24 bits pixels to 32 bits, keeping the channel order and setting the alpha to opaque.
+     * Uses AVX2 or SSSE3 when the CPU supports them, plain C++ otherwise
+     *
+     * @param source The 24 bits pixels
+     * @param destination Where to write the 32 bits pixels to
+     * @param pixels The amount of pixels in the row
+     */
+    void expandRow (const uint8_t* source, uint8_t* destination, uint32_t pixels);
+
+    /**
+     * Plain C++ version of expandRow, also takes care of the pixels left by the vectorized ones
+     */
+    void expandRowScalar (const uint8_t* source, uint8_t* destination, uint32_t pixels);
+
+#if defined(__x86_64__) || defined(__i386__)
+#define PIXEL_CONVERSION_X86 1
+    /**
+     * SSSE3 version of expandRow, the CPU must support it
+     */
+    void expandRowSSSE3 (const uint8_t* source, uint8_t* destination, uint32_t pixels);
+    /**
+     * AVX2 version of expandRow, the CPU must support it
+     */
+    void expandRowAVX2 (const uint8_t* source, uint8_t* destination, uint32_t pixels);
+#endif /* __x86_64__ || __i386__ */
+
+    /**
+     * Converts a bitmap to 32 bits and flips it vertically in one go, the equivalent of
+     * FreeImage_FlipVertical + FreeImage_ConvertTo32Bits without the intermediate copies
+     *
+     * @param bitmap The bitmap to convert, it's not modified
+     *
+     * @return The new 32 bits bitmap, nullptr if the bitmap's format is not supported (only 24 and 32 bits are)
+     */
+    FIBITMAP* convertFlipped (FIBITMAP* bitmap);
+}
@@ -54,7 +54,6 @@ CScene::CScene (
 
 CScene* CScene::fromFile (const std::string& filename, CProject& project, CContainer* container)
 {
-    std::string stringContent = WallpaperEngine::FileSystem::loadFullFile (filename, container);
     json content = json::parse (WallpaperEngine::FileSystem::loadFullFile (filename, container));
 
     auto camera_it = jsonFindRequired (content, "camera", "Scenes must have a defined camera");
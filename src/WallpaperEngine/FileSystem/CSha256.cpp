@@ -0,0 +1,114 @@
+#include "CSha256.h"
+
+#include <algorithm>
+#include <cstring>
+
+using namespace WallpaperEngine::FileSystem;
+
+static uint32_t rotate (uint32_t value, int bits)
+{
+    return (value >> bits) | (value << (32 - bits));
+}
+
+void CSha256::update (const void* data, size_t length)
+{
+    const auto* bytes = static_cast <const uint8_t*> (data);
+
+    this->m_length += length;
+
+    while (length > 0)
+    {
+        size_t count = std::min (length, sizeof (this->m_block) - this->m_used);
+
+        memcpy (this->m_block + this->m_used, bytes, count);
+
+        this->m_used += count;
+        bytes += count;
+        length -= count;
+
+        if (this->m_used == sizeof (this->m_block))
+        {
+            this->transform ();
+            this->m_used = 0;
+        }
+    }
+}
+
+Digest CSha256::finish ()
+{
+    uint64_t bits = this->m_length * 8;
+    uint8_t padding [sizeof (this->m_block) + 8] = { 0x80 };
+    size_t count = (this->m_used < 56 ? 56 : 120) - this->m_used;
+
+    for (int i = 0; i < 8; i ++)
+        padding [count + i] = static_cast <uint8_t> (bits >> (56 - i * 8));
+
+    this->update (padding, count + 8);
+
+    Digest digest {};
+
+    for (int i = 0; i < 32; i ++)
+        digest [i] = static_cast <uint8_t> (this->m_state [i / 4] >> (24 - (i % 4) * 8));
+
+    return digest;
+}
+
+void CSha256::transform ()
+{
+    static const uint32_t k [64] = {
+        0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5, 0x3956c25b, 0x59f111f1, 0x923f82a4, 0xab1c5ed5,
+        0xd807aa98, 0x12835b01, 0x243185be, 0x550c7dc3, 0x72be5d74, 0x80deb1fe, 0x9bdc06a7, 0xc19bf174,
+        0xe49b69c1, 0xefbe4786, 0x0fc19dc6, 0x240ca1cc, 0x2de92c6f, 0x4a7484aa, 0x5cb0a9dc, 0x76f988da,
+        0x983e5152, 0xa831c66d, 0xb00327c8, 0xbf597fc7, 0xc6e00bf3, 0xd5a79147, 0x06ca6351, 0x14292967,
+        0x27b70a85, 0x2e1b2138, 0x4d2c6dfc, 0x53380d13, 0x650a7354, 0x766a0abb, 0x81c2c92e, 0x92722c85,
+        0xa2bfe8a1, 0xa81a664b, 0xc24b8b70, 0xc76c51a3, 0xd192e819, 0xd6990624, 0xf40e3585, 0x106aa070,
+        0x19a4c116, 0x1e376c08, 0x2748774c, 0x34b0bcb5, 0x391c0cb3, 0x4ed8aa4a, 0x5b9cca4f, 0x682e6ff3,
+        0x748f82ee, 0x78a5636f, 0x84c87814, 0x8cc70208, 0x90befffa, 0xa4506ceb, 0xbef9a3f7, 0xc67178f2
+    };
+
+    uint32_t w [64];
+
+    for (int i = 0; i < 16; i ++)
+        w [i] =
+            (static_cast <uint32_t> (this->m_block [i * 4]) << 24) |
+            (static_cast <uint32_t> (this->m_block [i * 4 + 1]) << 16) |
+            (static_cast <uint32_t> (this->m_block [i * 4 + 2]) << 8) |
+            static_cast <uint32_t> (this->m_block [i * 4 + 3]);
+
+    for (int i = 16; i < 64; i ++)
+    {
+        uint32_t s0 = rotate (w [i - 15], 7) ^ rotate (w [i - 15], 18) ^ (w [i - 15] >> 3);
+        uint32_t s1 = rotate (w [i - 2], 17) ^ rotate (w [i - 2], 19) ^ (w [i - 2] >> 10);
+
+        w [i] = w [i - 16] + s0 + w [i - 7] + s1;
+    }
+
+    uint32_t a = this->m_state [0], b = this->m_state [1], c = this->m_state [2], d = this->m_state [3];
+    uint32_t e = this->m_state [4], f = this->m_state [5], g = this->m_state [6], h = this->m_state [7];
+
+    for (int i = 0; i < 64; i ++)
+    {
+        uint32_t s1 = rotate (e, 6) ^ rotate (e, 11) ^ rotate (e, 25);
+        uint32_t temp1 = h + s1 + ((e & f) ^ (~e & g)) + k [i] + w [i];
+        uint32_t s0 = rotate (a, 2) ^ rotate (a, 13) ^ rotate (a, 22);
+        uint32_t temp2 = s0 + ((a & b) ^ (a & c) ^ (b & c));
+
+        h = g;
+        g = f;
+        f = e;
+        e = d + temp1;
+        d = c;
+        c = b;
+        b = a;
+        a = temp1 + temp2;
+    }
+
+    this->m_state [0] += a;
+    this->m_state [1] += b;
+    this->m_state [2] += c;
+    this->m_state [3] += d;
+    this->m_state [4] += e;
+    this->m_state [5] += f;
+    this->m_state [6] += g;
+    this->m_state [7] += h;
+}
\ No newline at end of file
@@ -0,0 +1,49 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+namespace WallpaperEngine::FileSystem
+{
+    /** SHA-256 digest */
+    using Digest = std::array <uint8_t, 32>;
+
+    /**
+     * Incremental SHA-256 (FIPS 180-4)
+     */
+    class CSha256
+    {
+    public:
+        /**
+         * Adds more data to the digest
+         *
+         * @param data The data to hash
+         * @param length The length of the data
+         */
+        void update (const void* data, size_t length);
+        /**
+         * Pads the data and calculates the digest, nothing else can be added afterwards
+         *
+         * @return The digest of all the data
+         */
+        Digest finish ();
+
+    private:
+        /**
+         * Processes the current block
+         */
+        void transform ();
+
+        /** The hash values */
+        uint32_t m_state [8] = {
+            0x6a09e667, 0xbb67ae85, 0x3c6ef372, 0xa54ff53a, 0x510e527f, 0x9b05688c, 0x1f83d9ab, 0x5be0cd19
+        };
+        /** The block being filled */
+        uint8_t m_block [64] = {};
+        /** Bytes used in the block */
+        size_t m_used = 0;
+        /** Total amount of bytes hashed */
+        uint64_t m_length = 0;
+    };
+}
@@ -1,25 +1,154 @@
 // filesystem includes
 #include "FileSystem.h"
+#include "CSha256.h"
 
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
 #include <iostream>
 
+#include "WallpaperEngine/Logging/CLog.h"
+
 using namespace WallpaperEngine;
 
-std::string FileSystem::loadFullFile (const std::string& file, WallpaperEngine::Assets::CContainer* containers)
+WallpaperEngine::Assets::CFileView FileSystem::loadFullFile (const std::string& file, WallpaperEngine::Assets::CContainer* containers)
+{
+    return containers->readFileAsView (file);
+}
+
+std::filesystem::path FileSystem::cacheDirectory (const std::string& subdirectory)
+{
+    std::filesystem::path path;
+    const char* cache = getenv ("XDG_CACHE_HOME");
+    const char* home = getenv ("HOME");
+
+    if (cache != nullptr && *cache != '\0')
+        path = cache;
+    else if (home != nullptr && *home != '\0')
+        path = std::filesystem::path (home) / ".cache";
+    else
+        sLog.exception ("Cannot find cache directory for the current user");
+
+    path = path / "linux-wallpaperengine" / subdirectory;
+
+    std::filesystem::create_directories (path);
+
+    return path;
+}
+
+void FileSystem::pruneCacheDirectory (const std::filesystem::path& directory, const std::string& extension, uintmax_t budget)
 {
-    uint32_t length = 0;
-    const void* contents = containers->readFile (file, &length);
+    struct CacheFile
+    {
+        std::filesystem::path path;
+        std::filesystem::file_time_type time;
+        uintmax_t size;
+    };
+
+    // temporary files are renamed as soon as they're written, older ones were left behind by a crash
+    auto staleTime = std::filesystem::file_time_type::clock::now () - std::chrono::hours (1);
+    std::vector <CacheFile> files;
+    uintmax_t total = 0;
+    std::error_code ec;
+
+    for (const auto& entry : std::filesystem::directory_iterator (directory, ec))
+    {
+        if (!entry.is_regular_file (ec))
+            continue;
+
+        auto time = entry.last_write_time (ec);
+
+        if (ec)
+            continue;
+
+        if (entry.path ().extension () == ".tmp")
+        {
+            if (time < staleTime)
+                std::filesystem::remove (entry.path (), ec);
+
+            continue;
+        }
+
+        if (entry.path ().extension () != extension)
+            continue;
+
+        uintmax_t size = entry.file_size (ec);
+
+        if (ec)
+            continue;
+
+        files.push_back ({entry.path (), time, size});
+        total += size;
+    }
 
-    // build a new buffer that can fit in the string
-    char* filedata = new char [length + 1];
-    // ensure there's a null termination at the end
-    memset (filedata, 0, length + 1);
-    // copy file contents over
-    memcpy (filedata, contents, length);
+    if (total <= budget)
+        return;
+
+    // loading a file touches it, so the oldest ones are the least recently used
+    std::sort (files.begin (), files.end (), [] (const CacheFile& a, const CacheFile& b)
+    {
+        return a.time < b.time;
+    });
+
+    size_t removed = 0;
+
+    for (const auto& cur : files)
+    {
+        if (total <= budget)
+            break;
+
+        if (!std::filesystem::remove (cur.path, ec))
+            continue;
+
+        total -= cur.size;
+        removed ++;
+    }
+
+    sLog.debug ("Removed ", removed, " files from the cache at ", directory);
+}
+
+void FileSystem::touchCacheFile (const std::filesystem::path& path)
+{
+    std::error_code ec;
+
+    std::filesystem::last_write_time (path, std::filesystem::file_time_type::clock::now (), ec);
+}
+
+uint64_t FileSystem::contentHash (const void* data, size_t length)
+{
+    // FNV-1a over 64-bit words, with an extra mix so the high bits take part too
+    const auto* bytes = static_cast <const uint8_t*> (data);
+    uint64_t hash = 0xcbf29ce484222325ULL ^ length;
+    size_t words = length / sizeof (uint64_t);
+
+    for (size_t i = 0; i < words; i ++)
+    {
+        uint64_t word;
+
+        memcpy (&word, bytes + i * sizeof (uint64_t), sizeof (uint64_t));
+
+        hash = (hash ^ word) * 0x100000001b3ULL;
+        hash ^= hash >> 29;
+    }
+
+    for (size_t i = words * sizeof (uint64_t); i < length; i ++)
+        hash = (hash ^ bytes [i]) * 0x100000001b3ULL;
+
+    return hash;
+}
+
+FileSystem::Digest FileSystem::contentDigest (std::initializer_list <std::string_view> parts)
+{
+    CSha256 sha;
 
-    std::string content = filedata;
+    for (const auto& cur : parts)
+    {
+        uint64_t length = cur.size ();
 
-    delete [] filedata;
+        sha.update (&length, sizeof (length));
+        sha.update (cur.data (), cur.size ());
+    }
 
-    return content;
-}
\ No newline at end of file
+    return sha.finish ();
+}
@@ -3,19 +3,69 @@
  */
 #pragma once
 
+#include <cstdint>
+#include <filesystem>
+#include <initializer_list>
 #include <string>
+#include <string_view>
 #include <vector>
 #include <nlohmann/json.hpp>
 
 #include "WallpaperEngine/Assets/CContainer.h"
+#include "WallpaperEngine/FileSystem/CSha256.h"
 
 namespace WallpaperEngine::FileSystem
 {
     /**
-     * Loads a full file into an std::string
+     * Loads a full file's contents as text, the data is not copied
      *
      * @param file
      * @return
      */
-    std::string loadFullFile (const std::string& file, WallpaperEngine::Assets::CContainer* containers);
+    WallpaperEngine::Assets::CFileView loadFullFile (const std::string& file, WallpaperEngine::Assets::CContainer* containers);
+
+    /**
+     * Resolves a directory inside the application's cache folder ($XDG_CACHE_HOME/linux-wallpaperengine
+     * or ~/.cache/linux-wallpaperengine), creating it if it doesn't exist
+     *
+     * @param subdirectory The directory inside the cache folder
+     * @return
+     */
+    std::filesystem::path cacheDirectory (const std::string& subdirectory);
+
+    /**
+     * Removes the least recently used files of a cache directory until they fit in the given budget,
+     * also takes care of temporary files left behind by instances that didn't finish writing them
+     *
+     * @param directory The cache directory
+     * @param extension The extension of the cache files (including the dot)
+     * @param budget Maximum amount of bytes the cache files can take
+     */
+    void pruneCacheDirectory (const std::filesystem::path& directory, const std::string& extension, uintmax_t budget);
+
+    /**
+     * Marks a cache file as used now, so it's the last one to be removed by pruneCacheDirectory
+     *
+     * @param path The cache file
+     */
+    void touchCacheFile (const std::filesystem::path& path);
+
+    /**
+     * Calculates a fast, non-cryptographic 64-bit hash of the given data,
+     * meant to key the different on-disk caches by content
+     *
+     * @param data The data to hash
+     * @param length The length of the data
+     * @return
+     */
+    uint64_t contentHash (const void* data, size_t length);
+
+    /**
+     * Calculates the SHA-256 digest of the given data, used to validate the on-disk caches
+     * so a contentHash collision or a stale file never loads the wrong contents
+     *
+     * @param parts The data to hash, the length of every part is hashed too so they cannot be confused
+     * @return
+     */
+    Digest contentDigest (std::initializer_list <std::string_view> parts);
 }
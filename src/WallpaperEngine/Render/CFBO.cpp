@@ -151,6 +151,21 @@ const std::vector<ITexture::TextureFrame*>& CFBO::getFrames () const
     return this->m_frames;
 }
 
+const CFrameTimeline* CFBO::getFrameTimeline () const
+{
+    return nullptr;
+}
+
+const glm::vec4* CFBO::getAtlasRect () const
+{
+    return nullptr;
+}
+
+bool CFBO::isAtlased () const
+{
+    return false;
+}
+
 const glm::vec4* CFBO::getResolution () const
 {
     return &this->m_resolution;
@@ -26,6 +26,9 @@ namespace WallpaperEngine::Render
         const uint32_t getRealWidth () const override;
         const uint32_t getRealHeight () const override;
         const std::vector<TextureFrame*>& getFrames () const override;
+        const CFrameTimeline* getFrameTimeline () const override;
+        const glm::vec4* getAtlasRect () const override;
+        bool isAtlased () const override;
         const glm::vec4* getResolution () const override;
         const bool isAnimated () const override;
 
@@ -18,15 +18,26 @@ namespace WallpaperEngine::Render
         m_driver (driver),
         m_app (app),
         m_input (input),
-        m_textureCache (new CTextureCache (*this))
+        m_textureCache (new CTextureCache (*this)),
+        m_programCache (new Shaders::CProgramCache ())
     {
     }
 
+    CRenderContext::~CRenderContext ()
+    {
+        // the caches free their OpenGL objects, the context is still current here
+        delete this->m_textureCache;
+        delete this->m_programCache;
+    }
+
     void CRenderContext::render ()
     {
         bool firstFrame = true;
         bool renderFrame = true;
 
+        // push the next batch of streamed textures to the GPU
+        this->m_textureCache->update ();
+
         for (const auto& cur : this->m_output->getViewports ())
         {
 #if !NDEBUG
@@ -96,8 +107,13 @@ namespace WallpaperEngine::Render
         return this->m_output;
     }
 
-    const ITexture* CRenderContext::resolveTexture (const std::string& name)
+    const ITexture* CRenderContext::resolveTexture (const std::string& name, glm::uvec2 displaySize)
+    {
+        return this->m_textureCache->resolve (name, displaySize);
+    }
+
+    Shaders::CProgramCache* CRenderContext::getProgramCache () const
     {
-        return this->m_textureCache->resolve (name);
+        return this->m_programCache;
     }
 }
\ No newline at end of file
@@ -4,6 +4,7 @@
 #include <glm/vec4.hpp>
 
 #include "CTextureCache.h"
+#include "WallpaperEngine/Render/Shaders/CProgramCache.h"
 #include "WallpaperEngine/Application/CWallpaperApplication.h"
 #include "WallpaperEngine/Input/CInputContext.h"
 #include "WallpaperEngine/Input/CMouseInput.h"
@@ -36,6 +37,7 @@ namespace WallpaperEngine
         {
         public:
             CRenderContext (const Drivers::Output::COutput* output, Drivers::CVideoDriver& driver, Input::CInputContext& input, CWallpaperApplication& app);
+            ~CRenderContext ();
 
             void render ();
             void setDefaultWallpaper (CWallpaper* wallpaper);
@@ -44,7 +46,8 @@ namespace WallpaperEngine
             [[nodiscard]] const CWallpaperApplication& getApp () const;
             [[nodiscard]] const Drivers::CVideoDriver& getDriver () const;
             [[nodiscard]] const Drivers::Output::COutput* getOutput () const;
-            const ITexture* resolveTexture (const std::string& name);
+            const ITexture* resolveTexture (const std::string& name, glm::uvec2 displaySize = {0, 0});
+            [[nodiscard]] Shaders::CProgramCache* getProgramCache () const;
 
         private:
             /** Video driver in use */
@@ -59,6 +62,8 @@ namespace WallpaperEngine
             CWallpaperApplication& m_app;
             /** Texture cache for the render */
             CTextureCache* m_textureCache;
+            /** Shader programs shared between passes */
+            Shaders::CProgramCache* m_programCache;
             /** Output driver that describes how the wallpapers are rendered */
             const Drivers::Output::COutput* m_output;
         };
@@ -18,7 +18,8 @@ CScene::CScene (Core::CScene* scene, CRenderContext& context, CAudioContext& aud
     CWallpaper (scene, Type, context, audioContext),
     m_mousePosition (),
     m_mousePositionLast (),
-    m_parallaxDisplacement ()
+    m_parallaxDisplacement (),
+    m_frameGlobals (new Shaders::CFrameGlobals ())
 {
     // setup the scene camera
     this->m_camera = new CCamera (this, scene->getCamera ());
@@ -162,6 +163,45 @@ CScene::CScene (Core::CScene* scene, CRenderContext& context, CAudioContext& aud
 
         this->m_objectsByRenderOrder.push_back (this->m_bloomObject);
     }
+
+    this->setupShaders ();
+}
+
+void CScene::setupShaders ()
+{
+    std::vector <Objects::CImage*> images;
+
+    for (const auto& cur : this->m_objects)
+        if (cur.second->is <Objects::CImage> ())
+            images.push_back (cur.second->as <Objects::CImage> ());
+
+    // the shaders were pre-processed in the background while the objects were created,
+    // send all of them to the driver before checking any so they're compiled in parallel
+    for (const auto& cur : images)
+    {
+        try
+        {
+            cur->compilePasses ();
+        }
+        catch (std::runtime_error& ex)
+        {
+            // this error message is already printed, so just show extra info about it
+            sLog.error ("Cannot setup image ", cur->getImage ()->getName ());
+        }
+    }
+
+    for (const auto& cur : images)
+    {
+        try
+        {
+            cur->finalizePasses ();
+        }
+        catch (std::runtime_error& ex)
+        {
+            // this error message is already printed, so just show extra info about it
+            sLog.error ("Cannot setup image ", cur->getImage ()->getName ());
+        }
+    }
 }
 
 Render::CObject* CScene::createObject (Core::CObject* object)
@@ -241,6 +281,16 @@ void CScene::renderFrame (glm::ivec4 viewport)
 
     glClear (GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 
+    auto projection = this->getScene ()->getOrthogonalProjection ();
+
+    // upload the values shared by every pass once instead of setting them on every pass
+    this->m_frameGlobals->update (
+        g_Time, this->m_mousePosition, this->m_mousePositionLast,
+        glm::vec2 (1.0 / projection->getWidth (), 1.0 / projection->getHeight ()),
+        this->getAudioContext ().getRecorder ()
+    );
+    this->m_frameGlobals->bind ();
+
     for (const auto& cur : this->m_objectsByRenderOrder)
         cur->render ();
 }
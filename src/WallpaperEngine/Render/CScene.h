@@ -6,6 +6,7 @@
 
 #include "WallpaperEngine/Render/CWallpaper.h"
 #include "WallpaperEngine/Render/CObject.h"
+#include "WallpaperEngine/Render/Shaders/CFrameGlobals.h"
 
 namespace WallpaperEngine::Render
 {
@@ -38,6 +39,10 @@ namespace WallpaperEngine::Render
 
     private:
         Render::CObject* createObject (Core::CObject* object);
+        /**
+         * Compiles the shaders of all the objects in the scene at once
+         */
+        void setupShaders ();
 
         CCamera* m_camera;
         CObject* m_bloomObject;
@@ -49,5 +54,7 @@ namespace WallpaperEngine::Render
         CFBO* _rt_4FrameBuffer;
         CFBO* _rt_8FrameBuffer;
         CFBO* _rt_Bloom;
+        /** Values shared by every pass, updated once per frame */
+        Shaders::CFrameGlobals* m_frameGlobals;
     };
 }
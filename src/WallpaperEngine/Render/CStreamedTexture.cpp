@@ -0,0 +1,157 @@
+#include "CStreamedTexture.h"
+
+using namespace WallpaperEngine::Render;
+
+CStreamedTexture::CStreamedTexture (CTexture* texture, GLuint placeholder, const uint64_t& frame) :
+    m_texture (texture),
+    m_fallback (nullptr),
+    m_placeholder (placeholder),
+    m_ready (false),
+    m_evicted (false),
+    m_frame (frame),
+    m_lastUsed (frame)
+{
+}
+
+CStreamedTexture::~CStreamedTexture ()
+{
+    delete this->m_fallback;
+    delete this->m_texture;
+}
+
+const GLuint CStreamedTexture::getTextureID (uint32_t imageIndex) const
+{
+    // textures are only bound when rendering, so this is a good measure of usage
+    this->m_lastUsed = this->m_frame;
+
+    if (this->m_ready)
+        return this->m_texture->getTextureID (imageIndex);
+
+    if (this->m_fallback != nullptr)
+        return this->m_fallback->getTextureID (imageIndex);
+
+    return this->m_placeholder;
+}
+
+const uint32_t CStreamedTexture::getTextureWidth (uint32_t imageIndex) const
+{
+    return this->m_texture->getTextureWidth (imageIndex);
+}
+
+const uint32_t CStreamedTexture::getTextureHeight (uint32_t imageIndex) const
+{
+    return this->m_texture->getTextureHeight (imageIndex);
+}
+
+const uint32_t CStreamedTexture::getRealWidth () const
+{
+    return this->m_texture->getRealWidth ();
+}
+
+const uint32_t CStreamedTexture::getRealHeight () const
+{
+    return this->m_texture->getRealHeight ();
+}
+
+const ITexture::TextureFormat CStreamedTexture::getFormat () const
+{
+    return this->m_texture->getFormat ();
+}
+
+const ITexture::TextureFlags CStreamedTexture::getFlags () const
+{
+    return this->m_texture->getFlags ();
+}
+
+const glm::vec4* CStreamedTexture::getResolution () const
+{
+    return this->m_texture->getResolution ();
+}
+
+const std::vector<ITexture::TextureFrame*>& CStreamedTexture::getFrames () const
+{
+    return this->m_texture->getFrames ();
+}
+
+const CFrameTimeline* CStreamedTexture::getFrameTimeline () const
+{
+    return this->m_texture->getFrameTimeline ();
+}
+
+const glm::vec4* CStreamedTexture::getAtlasRect () const
+{
+    if (this->m_ready)
+        return this->m_texture->getAtlasRect ();
+
+    if (this->m_fallback != nullptr)
+        return this->m_fallback->getAtlasRect ();
+
+    // the placeholder is a texture on its own
+    return nullptr;
+}
+
+bool CStreamedTexture::isAtlased () const
+{
+    // the region is reserved when the texture is created, so this is known even with the placeholder bound
+    return this->m_texture->isAtlased ();
+}
+
+const bool CStreamedTexture::isAnimated () const
+{
+    return this->m_texture->isAnimated ();
+}
+
+CTexture* CStreamedTexture::getTexture () const
+{
+    return this->m_texture;
+}
+
+bool CStreamedTexture::isReady () const
+{
+    return this->m_ready;
+}
+
+void CStreamedTexture::setReady ()
+{
+    this->m_ready = true;
+
+    // the previous texture is not needed anymore
+    delete this->m_fallback;
+    this->m_fallback = nullptr;
+}
+
+void CStreamedTexture::setTexture (CTexture* texture)
+{
+    if (this->m_ready)
+    {
+        delete this->m_fallback;
+        this->m_fallback = this->m_texture;
+    }
+    else
+        delete this->m_texture;
+
+    this->m_texture = texture;
+    this->m_ready = false;
+    this->m_evicted = false;
+}
+
+void CStreamedTexture::evict ()
+{
+    this->m_texture->releaseTextures ();
+
+    delete this->m_fallback;
+    this->m_fallback = nullptr;
+
+    this->m_ready = false;
+    this->m_evicted = true;
+}
+
+bool CStreamedTexture::isEvicted () const
+{
+    return this->m_evicted;
+}
+
+uint64_t CStreamedTexture::getLastUsed () const
+{
+    return this->m_lastUsed;
+}
@@ -0,0 +1,103 @@
+#pragma once
+
+#include "WallpaperEngine/Assets/CTexture.h"
+#include "WallpaperEngine/Assets/ITexture.h"
+
+using namespace WallpaperEngine::Assets;
+
+namespace WallpaperEngine::Render
+{
+    /**
+     * A texture that's streamed to the GPU, renders a placeholder until all of its
+     * mipmaps are uploaded or while it's evicted from GPU memory.
+     *
+     * When the texture is replaced (to load it with more or less detail) the previous
+     * one is rendered until the new one is ready
+     */
+    class CStreamedTexture : public ITexture
+    {
+    public:
+        /**
+         * @param texture The texture being streamed
+         * @param placeholder The OpenGL texture to use until the texture is ready
+         * @param frame The current frame number, used to keep track of when the texture was last used
+         */
+        CStreamedTexture (CTexture* texture, GLuint placeholder, const uint64_t& frame);
+        ~CStreamedTexture ();
+
+        /** @inheritdoc */
+        [[nodiscard]] const GLuint getTextureID (uint32_t imageIndex = 0) const override;
+        /** @inheritdoc */
+        [[nodiscard]] const uint32_t getTextureWidth (uint32_t imageIndex = 0) const override;
+        /** @inheritdoc */
+        [[nodiscard]] const uint32_t getTextureHeight (uint32_t imageIndex = 0) const override;
+        /** @inheritdoc */
+        [[nodiscard]] const uint32_t getRealWidth () const override;
+        /** @inheritdoc */
+        [[nodiscard]] const uint32_t getRealHeight () const override;
+        /** @inheritdoc */
+        [[nodiscard]] const TextureFormat getFormat () const override;
+        /** @inheritdoc */
+        [[nodiscard]] const TextureFlags getFlags () const override;
+        /** @inheritdoc */
+        [[nodiscard]] const glm::vec4* getResolution () const override;
+        /** @inheritdoc */
+        [[nodiscard]] const std::vector<TextureFrame*>& getFrames () const override;
+        /** @inheritdoc */
+        [[nodiscard]] const CFrameTimeline* getFrameTimeline () const override;
+        /** @inheritdoc */
+        [[nodiscard]] const glm::vec4* getAtlasRect () const override;
+        /** @inheritdoc */
+        [[nodiscard]] bool isAtlased () const override;
+        /** @inheritdoc */
+        [[nodiscard]] const bool isAnimated () const override;
+
+        /**
+         * @return The texture being streamed
+         */
+        [[nodiscard]] CTexture* getTexture () const;
+        /**
+         * @return If all the mipmaps are already on the GPU
+         */
+        [[nodiscard]] bool isReady () const;
+        /**
+         * Swaps the placeholder for the real texture
+         */
+        void setReady ();
+        /**
+         * Replaces the texture being streamed, used when reloading a texture with a different
+         * amount of detail. If the current texture is ready it's rendered until the new one is
+         *
+         * @param texture The new texture to stream
+         */
+        void setTexture (CTexture* texture);
+        /**
+         * Frees the texture's GPU memory, the placeholder is rendered until it's reloaded
+         */
+        void evict ();
+        /**
+         * @return If the texture was evicted from GPU memory
+         */
+        [[nodiscard]] bool isEvicted () const;
+        /**
+         * @return The last frame the texture was used in
+         */
+        [[nodiscard]] uint64_t getLastUsed () const;
+
+    private:
+        /** The texture being streamed */
+        CTexture* m_texture;
+        /** The previous texture, rendered while the current one is streamed */
+        CTexture* m_fallback;
+        /** The texture to render while streaming if there's no previous texture */
+        GLuint m_placeholder;
+        /** If the texture was completely uploaded */
+        bool m_ready;
+        /** If the texture was evicted from GPU memory */
+        bool m_evicted;
+        /** The current frame number */
+        const uint64_t& m_frame;
+        /** The last frame the texture was used in */
+        mutable uint64_t m_lastUsed;
+    };
+}
@@ -0,0 +1,107 @@
+#include "common.h"
+#include "CTextureAtlas.h"
+
+#include <algorithm>
+
+using namespace WallpaperEngine::Render;
+
+CTextureAtlas::~CTextureAtlas ()
+{
+    for (auto& cur : this->m_pages)
+        glDeleteTextures (1, &cur.texture);
+}
+
+bool CTextureAtlas::allocate (glm::uvec2 size, GLuint& texture, uint32_t& x, uint32_t& y, bool canGrow)
+{
+    if (size.x == 0 || size.y == 0 || size.x > MaxTextureSize || size.y > MaxTextureSize)
+        return false;
+
+    for (auto& cur : this->m_pages)
+    {
+        if (!allocate (cur, size, x, y))
+            continue;
+
+        texture = cur.texture;
+        return true;
+    }
+
+    if (!canGrow)
+        return false;
+
+    this->m_pages.push_back (createPage ());
+
+    Page& page = this->m_pages.back ();
+
+    if (!allocate (page, size, x, y))
+        return false;
+
+    sLog.debug ("Created texture atlas page ", this->m_pages.size (), " (", PageSize, "x", PageSize, ")");
+
+    texture = page.texture;
+    return true;
+}
+
+bool CTextureAtlas::allocate (Page& page, glm::uvec2 size, uint32_t& x, uint32_t& y)
+{
+    // start a new shelf if the texture doesn't fit in the current one
+    if (page.shelfX + size.x > PageSize)
+    {
+        if (page.shelfY + page.shelfHeight + size.y > PageSize)
+            return false;
+
+        page.shelfY += page.shelfHeight;
+        page.shelfHeight = 0;
+        page.shelfX = 0;
+    }
+
+    if (page.shelfY + size.y > PageSize)
+        return false;
+
+    x = page.shelfX;
+    y = page.shelfY;
+
+    page.shelfX += size.x + Padding;
+    page.shelfHeight = std::max (page.shelfHeight, size.y + Padding);
+
+    return true;
+}
+
+CTextureAtlas::Page CTextureAtlas::createPage ()
+{
+    Page page;
+
+    glGenTextures (1, &page.texture);
+    glBindBuffer (GL_PIXEL_UNPACK_BUFFER, 0);
+    glBindTexture (GL_TEXTURE_2D, page.texture);
+
+    // pages have no mipmaps, only textures drawn at roughly their own size are placed in them
+    // and they're clamped to their region by the shaders
+    glTexParameteri (GL_TEXTURE_2D, GL_TEXTURE_BASE_LEVEL, 0);
+    glTexParameteri (GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, 0);
+    glTexParameteri (GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri (GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    glTexParameteri (GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glTexParameteri (GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+    glTexImage2D (GL_TEXTURE_2D, 0, GL_RGBA8, PageSize, PageSize, 0, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+
+#if !NDEBUG
+    glObjectLabel (GL_TEXTURE, page.texture, -1, "Texture atlas");
+#endif /* NDEBUG */
+
+    return page;
+}
+
+glm::uvec2 CTextureAtlas::getPageSize () const
+{
+    return { PageSize, PageSize };
+}
+
+size_t CTextureAtlas::getPageCount () const
+{
+    return this->m_pages.size ();
+}
+
+size_t CTextureAtlas::getMemorySize () const
+{
+    return this->m_pages.size () * PageMemorySize;
+}
@@ -0,0 +1,90 @@
+#pragma once
+
+#include <GL/glew.h>
+#include <cstdint>
+#include <vector>
+#include <glm/vec2.hpp>
+
+namespace WallpaperEngine::Render
+{
+    /**
+     * Packs small textures into shared RGBA8 textures so the scene uses less
+     * texture objects and the same texture stays bound between passes.
+     *
+     * Textures are placed in shelves, a row of textures as tall as the tallest of them,
+     * new pages are created once the current ones are full.
+     *
+     * Pages have no mipmaps, so textures that are drawn smaller than they are would alias
+     * and must not be placed in the atlas
+     */
+    class CTextureAtlas
+    {
+    public:
+        /** Size of every page (in pixels) */
+        static constexpr uint32_t PageSize = 2048;
+        /** Biggest texture (in pixels) that is packed, bigger ones would waste too much of the page */
+        static constexpr uint32_t MaxTextureSize = 256;
+        /** Space left between textures (in pixels) */
+        static constexpr uint32_t Padding = 1;
+        /** GPU memory used by every page (in bytes) */
+        static constexpr size_t PageMemorySize = static_cast <size_t> (PageSize) * PageSize * 4;
+
+        CTextureAtlas () = default;
+        ~CTextureAtlas ();
+
+        /**
+         * Reserves space for a texture of the given size
+         *
+         * @param size The size of the texture (in pixels)
+         * @param texture Output for the page's texture
+         * @param x Output for the horizontal position of the texture inside the page
+         * @param y Output for the vertical position of the texture inside the page
+         * @param canGrow Whether a new page can be created if the texture doesn't fit in the current ones
+         *
+         * @return If the space could be reserved
+         */
+        bool allocate (glm::uvec2 size, GLuint& texture, uint32_t& x, uint32_t& y, bool canGrow = true);
+        /**
+         * @return The size of every page (in pixels)
+         */
+        [[nodiscard]] glm::uvec2 getPageSize () const;
+        /**
+         * @return The amount of pages created so far
+         */
+        [[nodiscard]] size_t getPageCount () const;
+        /**
+         * @return The GPU memory used by the pages (in bytes)
+         */
+        [[nodiscard]] size_t getMemorySize () const;
+
+    private:
+        /**
+         * A texture that textures are packed into
+         */
+        struct Page
+        {
+            /** OpenGL's texture ID */
+            GLuint texture;
+            /** Vertical position of the shelf being filled */
+            uint32_t shelfY = 0;
+            /** Height of the shelf being filled */
+            uint32_t shelfHeight = 0;
+            /** Horizontal position of the next texture in the shelf */
+            uint32_t shelfX = 0;
+        };
+
+        /**
+         * Tries to reserve space in the given page
+         *
+         * @return If the space could be reserved
+         */
+        static bool allocate (Page& page, glm::uvec2 size, uint32_t& x, uint32_t& y);
+        /**
+         * @return A new, empty page
+         */
+        static Page createPage ();
+
+        /** The pages created so far */
+        std::vector <Page> m_pages;
+    };
+}
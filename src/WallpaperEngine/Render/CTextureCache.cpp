@@ -1,30 +1,97 @@
+#include "common.h"
 #include "CTextureCache.h"
 
 #include "WallpaperEngine/Render/Helpers/CContextAware.h"
 #include "WallpaperEngine/Assets/CAssetLoadException.h"
+#include "WallpaperEngine/Threading/CThreadPool.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <vector>
+#include <glm/common.hpp>
 
 using namespace WallpaperEngine::Render;
 using namespace WallpaperEngine::Assets;
 
 CTextureCache::CTextureCache (CRenderContext& context) :
-    Helpers::CContextAware (context)
+    Helpers::CContextAware (context),
+    m_frame (0),
+    m_budget (static_cast <size_t> (context.getApp ().getContext ().settings.render.textureBudget) * 1024 * 1024),
+    m_residentSize (0),
+    m_evictions (0),
+    m_placeholder (0),
+    m_uploadBuffer (0),
+    m_uploadMapping (nullptr),
+    m_fences (),
+    m_segment (0),
+    m_atlas (nullptr),
+    m_transcode (false)
 {
+    const auto& settings = context.getApp ().getContext ().settings.render;
+
+    if (settings.textureAtlas)
+        this->m_atlas = new CTextureAtlas ();
+
+    if (settings.textureCompression)
+    {
+        this->m_transcode = GLEW_EXT_texture_compression_s3tc;
+
+        if (!this->m_transcode)
+            sLog.error ("Texture compression requested but the GPU doesn't support S3TC, textures will be uncompressed");
+    }
 }
 
 CTextureCache::~CTextureCache ()
-= default;
+{
+    // do not leave workers decoding textures nobody is going to use
+    for (auto& cur : this->m_pending)
+        if (!cur.decodeFinished && cur.decoded.valid ())
+            cur.decoded.wait ();
+
+    // every texture in the cache was loaded from a container, the streamed textures own them
+    for (const auto& [filename, managed] : this->m_managed)
+        delete managed.texture;
+
+    this->m_pending.clear ();
+    this->m_managed.clear ();
+    this->m_textureCache.clear ();
+
+    if (this->m_uploadBuffer != 0)
+        this->releaseUploadBuffer (true);
+
+    if (this->m_placeholder != 0)
+        glDeleteTextures (1, &this->m_placeholder);
 
-const ITexture* CTextureCache::resolve (const std::string& filename)
+    // atlased textures do not own their pages, so the atlas goes last
+    delete this->m_atlas;
+}
+
+const ITexture* CTextureCache::resolve (const std::string& filename, glm::uvec2 displaySize)
 {
     auto found = this->m_textureCache.find (filename);
 
     if (found != this->m_textureCache.end ())
+    {
+        auto managed = this->m_managed.find (filename);
+
+        // requests without a display size take whatever detail was loaded
+        if (managed != this->m_managed.end () && displaySize.x != 0 && displaySize.y != 0 &&
+            (managed->second.displaySize.x != 0 || managed->second.displaySize.y != 0))
+        {
+            managed->second.displaySize = glm::max (managed->second.displaySize, displaySize);
+            managed->second.outdated =
+                getBaseLevel (managed->second.texture->getTexture (), managed->second.displaySize) <
+                managed->second.texture->getTexture ()->getBaseLevel ();
+        }
+
         return (*found).second;
+    }
 
     // search for the texture in all the different containers just in case
     for (auto it : this->getContext ().getApp ().getBackgrounds ())
     {
-        const ITexture* texture = it.second->getContainer ()->readTexture (filename);
+        const ITexture* texture = this->load (it.second->getContainer (), filename, displaySize);
 
         this->store (filename, texture);
 
@@ -34,7 +101,7 @@ const ITexture* CTextureCache::resolve (const std::string& filename)
     if (this->getContext ().getApp ().getDefaultBackground () != nullptr)
     {
         const ITexture* texture =
-            this->getContext ().getApp ().getDefaultBackground ()->getContainer ()->readTexture (filename);
+            this->load (this->getContext ().getApp ().getDefaultBackground ()->getContainer (), filename, displaySize);
 
         this->store (filename, texture);
 
@@ -47,4 +114,460 @@ const ITexture* CTextureCache::resolve (const std::string& filename)
 void CTextureCache::store (const std::string& name, const ITexture* texture)
 {
     this->m_textureCache.insert_or_assign (name, texture);
-}
\ No newline at end of file
+}
+
+const ITexture* CTextureCache::load (const CContainer* container, const std::string& filename, glm::uvec2 displaySize)
+{
+    ManagedTexture managed;
+
+    managed.container = container;
+    managed.displaySize = displaySize;
+
+    this->stream (filename, managed);
+    this->m_managed.insert_or_assign (filename, managed);
+
+    return managed.texture;
+}
+
+void CTextureCache::stream (const std::string& filename, ManagedTexture& managed, bool reduced)
+{
+    // get the texture's filename (usually .tex)
+    std::string path = "materials/" + filename + ".tex";
+
+    // only the header is parsed here, the textures are created without any data
+    uint32_t length = 0;
+    std::shared_ptr <const uint8_t[]> contents = managed.container->readFile (path, &length);
+    auto* texture = new CTexture (std::move (contents), length, true);
+
+    // skip the mipmaps that have more detail than the screen can show
+    uint32_t baseLevel = getBaseLevel (texture, managed.displaySize);
+
+    if (reduced)
+        baseLevel = std::max (baseLevel, getBaseLevel (texture, {EvictedSize, EvictedSize}));
+
+    // the atlas' pages have no mipmaps, so only textures drawn at roughly their own size can go there
+    managed.atlased =
+        baseLevel == 0 && managed.displaySize.x != 0 && managed.displaySize.y != 0 && this->placeInAtlas (texture);
+
+    if (!managed.atlased)
+    {
+        texture->setTranscoding (this->m_transcode);
+        texture->setBaseLevel (baseLevel);
+        texture->allocate ();
+
+        if (texture->getBaseLevel () > 0)
+            sLog.debug ("Skipping ", texture->getBaseLevel (), " mipmap levels of ", path);
+    }
+
+    if (managed.texture == nullptr)
+        managed.texture = new CStreamedTexture (texture, this->getPlaceholder (), this->m_frame);
+    else
+        managed.texture->setTexture (texture);
+
+    managed.outdated = false;
+    managed.reduced = reduced;
+
+    // the atlas' pages are counted on their own, so atlased textures do not count towards the budget
+    managed.size = managed.atlased ? 0 : texture->getMemorySize ();
+    this->m_residentSize += managed.size;
+
+#if !NDEBUG
+    if (!managed.atlased)
+        glObjectLabel (GL_TEXTURE, texture->getTextureID (), -1, path.c_str ());
+#endif /* NDEBUG */
+
+    PendingTexture pending;
+
+    pending.filename = path;
+    pending.texture = managed.texture;
+    pending.decoded = Threading::CThreadPool::get ().submit ([texture] () { texture->decode (); });
+
+    this->m_pending.push_back (std::move (pending));
+}
+
+bool CTextureCache::placeInAtlas (CTexture* texture)
+{
+    if (this->m_atlas == nullptr || !texture->canBeAtlased ())
+        return false;
+
+    GLuint page;
+    uint32_t x, y;
+    // atlased textures cannot be evicted, so new pages have to fit in the budget
+    bool canGrow = this->m_budget == 0 || this->getResidentSize () + CTextureAtlas::PageMemorySize <= this->m_budget;
+
+    if (!this->m_atlas->allocate ({texture->getTextureWidth (), texture->getTextureHeight ()}, page, x, y, canGrow))
+        return false;
+
+    texture->setAtlasRegion (page, x, y, this->m_atlas->getPageSize ());
+
+    return true;
+}
+
+uint32_t CTextureCache::getBaseLevel (const CTexture* texture, glm::uvec2 displaySize)
+{
+    if (displaySize.x == 0 || displaySize.y == 0)
+        return 0;
+
+    uint32_t level = 0;
+    uint32_t mipmapCount = texture->getMipmapCount (0);
+
+    // keep going down while the next level is still as big as what's displayed
+    while (level + 1 < mipmapCount &&
+           (texture->getRealWidth () >> (level + 1)) >= displaySize.x &&
+           (texture->getRealHeight () >> (level + 1)) >= displaySize.y)
+        level ++;
+
+    return level;
+}
+
+void CTextureCache::reloadEvicted ()
+{
+    for (auto& [filename, managed] : this->m_managed)
+    {
+        bool used = managed.texture->getLastUsed () + 1 >= this->m_frame;
+        bool reload;
+
+        // evicted textures without smaller mipmaps are reloaded as soon as they're used again
+        if (managed.texture->isEvicted ())
+            reload = used;
+        // textures that are still streaming are picked up once they're done
+        else
+            reload = managed.texture->isReady () && (managed.outdated || (managed.reduced && used));
+
+        if (!reload)
+            continue;
+
+        // the current texture is rendered until the new one is ready, its memory is freed then
+        this->m_residentSize -= managed.size;
+        managed.size = 0;
+
+        try
+        {
+            this->stream (filename, managed);
+        }
+        catch (std::exception& e)
+        {
+            sLog.error ("Cannot reload texture ", filename, ": ", e.what ());
+        }
+    }
+}
+
+void CTextureCache::enforceBudget ()
+{
+    if (this->m_budget == 0 || this->getResidentSize () <= this->m_budget)
+        return;
+
+    std::vector <std::pair <const std::string, ManagedTexture>*> candidates;
+
+    // textures still being streamed, used in the last frame, in the atlas or already evicted must stay
+    for (auto& cur : this->m_managed)
+        if (!cur.second.atlased && !cur.second.reduced && cur.second.texture->isReady () &&
+            cur.second.texture->getLastUsed () + 1 < this->m_frame)
+            candidates.push_back (&cur);
+
+    std::sort (
+        candidates.begin (), candidates.end (),
+        [] (const auto* a, const auto* b)
+        {
+            return a->second.texture->getLastUsed () < b->second.texture->getLastUsed ();
+        }
+    );
+
+    size_t evicted = 0;
+
+    for (auto cur : candidates)
+    {
+        if (this->getResidentSize () <= this->m_budget)
+            break;
+
+        auto& [filename, managed] = *cur;
+        CTexture* texture = managed.texture->getTexture ();
+
+        managed.texture->evict ();
+        this->m_residentSize -= managed.size;
+        managed.size = 0;
+        evicted ++;
+
+        // textures without smaller mipmaps render the placeholder until they're used again
+        if (getBaseLevel (texture, {EvictedSize, EvictedSize}) <= texture->getBaseLevel ())
+            continue;
+
+        try
+        {
+            this->stream (filename, managed, true);
+        }
+        catch (std::exception& e)
+        {
+            sLog.error ("Cannot reload texture ", filename, ": ", e.what ());
+        }
+    }
+
+    this->m_evictions += evicted;
+
+    if (evicted > 0)
+        sLog.debug (
+            "Evicted ", evicted, " textures, ", this->getResidentCount (), " textures use ",
+            this->getResidentSize () / (1024 * 1024), "MiB of the ", this->m_budget / (1024 * 1024), "MiB budget"
+        );
+}
+
+size_t CTextureCache::getResidentSize () const
+{
+    if (this->m_atlas == nullptr)
+        return this->m_residentSize;
+
+    return this->m_residentSize + this->m_atlas->getMemorySize ();
+}
+
+size_t CTextureCache::getResidentCount () const
+{
+    size_t count = 0;
+
+    for (const auto& [filename, managed] : this->m_managed)
+        if (!managed.texture->isEvicted () && !managed.reduced)
+            count ++;
+
+    return count;
+}
+
+size_t CTextureCache::getEvictionCount () const
+{
+    return this->m_evictions;
+}
+
+GLuint CTextureCache::getPlaceholder ()
+{
+    if (this->m_placeholder != 0)
+        return this->m_placeholder;
+
+    // a single transparent pixel
+    const uint8_t pixel [4] = { 0, 0, 0, 0 };
+
+    glGenTextures (1, &this->m_placeholder);
+    glBindBuffer (GL_PIXEL_UNPACK_BUFFER, 0);
+    glBindTexture (GL_TEXTURE_2D, this->m_placeholder);
+    glTexParameteri (GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    glTexParameteri (GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    glTexImage2D (GL_TEXTURE_2D, 0, GL_RGBA8, 1, 1, 0, GL_RGBA, GL_UNSIGNED_BYTE, pixel);
+
+    return this->m_placeholder;
+}
+
+void CTextureCache::createUploadBuffer ()
+{
+    constexpr size_t size = UploadSegmentSize * UploadSegments;
+
+    glGenBuffers (1, &this->m_uploadBuffer);
+    glBindBuffer (GL_PIXEL_UNPACK_BUFFER, this->m_uploadBuffer);
+
+    if (GLEW_ARB_buffer_storage)
+    {
+        GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+
+        glBufferStorage (GL_PIXEL_UNPACK_BUFFER, size, nullptr, flags);
+        this->m_uploadMapping = static_cast <char*> (glMapBufferRange (GL_PIXEL_UNPACK_BUFFER, 0, size, flags));
+
+        if (this->m_uploadMapping != nullptr)
+            return;
+
+        // immutable storage cannot be re-specified, so start over with a normal buffer
+        glDeleteBuffers (1, &this->m_uploadBuffer);
+        glGenBuffers (1, &this->m_uploadBuffer);
+        glBindBuffer (GL_PIXEL_UNPACK_BUFFER, this->m_uploadBuffer);
+    }
+
+    glBufferData (GL_PIXEL_UNPACK_BUFFER, size, nullptr, GL_STREAM_DRAW);
+}
+
+void CTextureCache::releaseUploadBuffer (bool force)
+{
+    // wait until the GPU is done with every segment
+    for (auto& fence : this->m_fences)
+    {
+        if (fence == nullptr)
+            continue;
+
+        if (!force && glClientWaitSync (fence, 0, 0) == GL_TIMEOUT_EXPIRED)
+            return;
+
+        glDeleteSync (fence);
+        fence = nullptr;
+    }
+
+    if (this->m_uploadMapping != nullptr)
+    {
+        glBindBuffer (GL_PIXEL_UNPACK_BUFFER, this->m_uploadBuffer);
+        glUnmapBuffer (GL_PIXEL_UNPACK_BUFFER);
+        glBindBuffer (GL_PIXEL_UNPACK_BUFFER, 0);
+    }
+
+    glDeleteBuffers (1, &this->m_uploadBuffer);
+
+    this->m_uploadBuffer = 0;
+    this->m_uploadMapping = nullptr;
+    this->m_segment = 0;
+}
+
+void CTextureCache::update ()
+{
+    this->m_frame ++;
+
+    this->reloadEvicted ();
+    this->enforceBudget ();
+    this->uploadPending ();
+}
+
+void CTextureCache::uploadPending ()
+{
+    if (this->m_pending.empty ())
+    {
+        if (this->m_uploadBuffer != 0)
+            this->releaseUploadBuffer ();
+
+        return;
+    }
+
+    GLsync& fence = this->m_fences [this->m_segment];
+
+    if (fence != nullptr)
+    {
+        // the GPU is still reading from this segment, try again next frame
+        if (glClientWaitSync (fence, 0, 0) == GL_TIMEOUT_EXPIRED)
+            return;
+
+        glDeleteSync (fence);
+        fence = nullptr;
+    }
+
+    if (this->m_uploadBuffer == 0)
+        this->createUploadBuffer ();
+
+    size_t segmentStart = this->m_segment * UploadSegmentSize;
+    char* mapping = nullptr;
+
+    glBindBuffer (GL_PIXEL_UNPACK_BUFFER, this->m_uploadBuffer);
+
+    if (this->m_uploadMapping != nullptr)
+        mapping = this->m_uploadMapping + segmentStart;
+    else
+        mapping = static_cast <char*> (glMapBufferRange (
+            GL_PIXEL_UNPACK_BUFFER, segmentStart, UploadSegmentSize,
+            GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_RANGE_BIT | GL_MAP_UNSYNCHRONIZED_BIT
+        ));
+
+    std::vector <UploadChunk> chunks;
+    std::vector <PendingTexture> finished;
+    size_t used = 0;
+
+    for (auto it = this->m_pending.begin (); it != this->m_pending.end () && used < UploadSegmentSize;)
+    {
+        if (!it->decodeFinished)
+        {
+            if (it->decoded.wait_for (std::chrono::seconds (0)) != std::future_status::ready)
+            {
+                it ++;
+                continue;
+            }
+
+            try
+            {
+                it->decoded.get ();
+            }
+            catch (std::exception& e)
+            {
+                // the placeholder will be kept for this texture
+                sLog.error ("Cannot decode texture ", it->filename, ": ", e.what ());
+                it = this->m_pending.erase (it);
+                continue;
+            }
+
+            it->decodeFinished = true;
+        }
+
+        CTexture* texture = it->texture->getTexture ();
+
+        // copy as many rows as the segment can hold
+        while (texture->getMipmapCount (it->image) > 0 && used < UploadSegmentSize)
+        {
+            uint32_t rowSize, rows;
+            const char* data = texture->getUploadData (it->image, it->level, rowSize, rows);
+            uint32_t count = 0;
+
+            if (data != nullptr && rowSize > 0 && it->row < rows)
+                count = std::min <size_t> (rows - it->row, (UploadSegmentSize - used) / rowSize);
+
+            if (count > 0 && mapping != nullptr)
+            {
+                memcpy (mapping + used, data + it->row * rowSize, count * rowSize);
+                chunks.push_back ({texture, it->image, it->level, it->row, count, segmentStart + used, nullptr});
+                // keep every chunk aligned in the buffer
+                used += (count * rowSize + 15) & ~static_cast <size_t> (15);
+                it->row += count;
+            }
+            else if (data != nullptr && it->row < rows)
+            {
+                // a single row larger than the segment (or no buffer to copy to), upload it straight away
+                if (used > 0 && mapping != nullptr)
+                    break;
+
+                chunks.push_back ({texture, it->image, it->level, it->row, rows - it->row, 0, data + it->row * rowSize});
+                it->row = rows;
+            }
+            else
+                it->row = rows;
+
+            if (it->row < rows)
+                continue;
+
+            // move on to the next mipmap
+            it->row = 0;
+
+            if (++ it->level >= texture->getMipmapCount (it->image))
+            {
+                it->level = 0;
+                it->image ++;
+            }
+        }
+
+        // there's data left, so the segment is full
+        if (texture->getMipmapCount (it->image) > 0)
+            break;
+
+        finished.push_back (std::move (*it));
+        it = this->m_pending.erase (it);
+    }
+
+    if (mapping != nullptr && this->m_uploadMapping == nullptr)
+        glUnmapBuffer (GL_PIXEL_UNPACK_BUFFER);
+
+    for (const auto& cur : chunks)
+    {
+        if (cur.source != nullptr)
+        {
+            glBindBuffer (GL_PIXEL_UNPACK_BUFFER, 0);
+            cur.texture->uploadRows (cur.image, cur.level, cur.row, cur.count, cur.source);
+            glBindBuffer (GL_PIXEL_UNPACK_BUFFER, this->m_uploadBuffer);
+        }
+        else
+            cur.texture->uploadRows (
+                cur.image, cur.level, cur.row, cur.count, reinterpret_cast <const void*> (cur.offset)
+            );
+    }
+
+    glBindBuffer (GL_PIXEL_UNPACK_BUFFER, 0);
+
+    if (used > 0)
+    {
+        // the segment can be reused once the GPU is done copying from it
+        fence = glFenceSync (GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+        this->m_segment = (this->m_segment + 1) % UploadSegments;
+    }
+
+    for (auto& cur : finished)
+    {
+        sLog.debug ("Streamed texture ", cur.filename, ": decoding took ", cur.texture->getTexture ()->getDecodeTime (), "ms");
+
+        cur.texture->getTexture ()->finishUpload ();
+        cur.texture->setReady ();
+    }
+}
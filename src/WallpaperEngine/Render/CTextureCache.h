@@ -1,10 +1,16 @@
 #pragma once
 
+#include <future>
+#include <list>
 #include <map>
 #include <string>
+#include <glm/vec2.hpp>
 
+#include "WallpaperEngine/Assets/CContainer.h"
 #include "WallpaperEngine/Assets/ITexture.h"
 #include "WallpaperEngine/Render/CRenderContext.h"
+#include "WallpaperEngine/Render/CStreamedTexture.h"
+#include "WallpaperEngine/Render/CTextureAtlas.h"
 #include "WallpaperEngine/Render/Helpers/CContextAware.h"
 
 using namespace WallpaperEngine::Assets;
@@ -28,10 +34,15 @@ namespace WallpaperEngine::Render
          * Checks if the given texture was already loaded and returns it
          * If the texture was not loaded yet, it tries to load it from the container
          *
+         * Textures loaded from containers are streamed: a placeholder is rendered
+         * until their data is decoded and uploaded by update
+         *
          * @param filename
+         * @param displaySize The size (in pixels) the texture is displayed at on screen, mipmaps
+         *                    bigger than needed are skipped. 0 loads the full texture
          * @return
          */
-        const ITexture* resolve (const std::string& filename);
+        const ITexture* resolve (const std::string& filename, glm::uvec2 displaySize = {0, 0});
 
         /**
          * Registers a texture in the cache
@@ -41,8 +52,189 @@ namespace WallpaperEngine::Render
          */
         void store (const std::string& name, const ITexture* texture);
 
+        /**
+         * Uploads the next batch of data for the textures being streamed and keeps
+         * the textures inside the GPU memory budget, should be called once per frame
+         * from the render thread
+         */
+        void update ();
+
+        /**
+         * @return The GPU memory used by the textures loaded by the cache and the atlas' pages (in bytes)
+         */
+        [[nodiscard]] size_t getResidentSize () const;
+        /**
+         * @return The amount of textures loaded by the cache that are in GPU memory with all their detail
+         */
+        [[nodiscard]] size_t getResidentCount () const;
+        /**
+         * @return The amount of times a texture was evicted from GPU memory
+         */
+        [[nodiscard]] size_t getEvictionCount () const;
+
     private:
+        /** Size of every segment of the upload buffer, this is also the upload budget per frame */
+        static constexpr size_t UploadSegmentSize = 8 * 1024 * 1024;
+        /** Amount of segments in the upload buffer, so the GPU can read from one while the next one is filled */
+        static constexpr size_t UploadSegments = 3;
+        /** Evicted textures keep the mipmaps down to this size (in pixels), so they're not replaced by the placeholder */
+        static constexpr uint32_t EvictedSize = 32;
+
+        /**
+         * A texture that is being decoded or uploaded
+         */
+        struct PendingTexture
+        {
+            /** The name the texture was requested as */
+            std::string filename;
+            /** The texture being streamed */
+            CStreamedTexture* texture;
+            /** Completes once the texture is decoded */
+            std::future <void> decoded;
+            /** Whether the decode result was already checked */
+            bool decodeFinished = false;
+            /** The image being uploaded */
+            uint32_t image = 0;
+            /** The mipmap level being uploaded */
+            uint32_t level = 0;
+            /** The next row to upload */
+            uint32_t row = 0;
+        };
+
+        /**
+         * A texture loaded from a container, so it can be evicted and reloaded
+         */
+        struct ManagedTexture
+        {
+            /** The container the texture comes from */
+            const CContainer* container = nullptr;
+            /** The texture handed out to the renderer */
+            CStreamedTexture* texture = nullptr;
+            /** The GPU memory the texture uses (in bytes) */
+            size_t size = 0;
+            /** The biggest size the texture is displayed at, 0 if the full texture is needed */
+            glm::uvec2 displaySize = {0, 0};
+            /** Whether the texture has to be reloaded with more detail */
+            bool outdated = false;
+            /** Whether the texture lives in the atlas, those are never evicted */
+            bool atlased = false;
+            /** Whether only the smallest mipmaps are loaded because the texture was evicted */
+            bool reduced = false;
+        };
+
+        /**
+         * A range of rows to upload in this frame
+         */
+        struct UploadChunk
+        {
+            /** The texture to upload to */
+            CTexture* texture;
+            /** The image to upload to */
+            uint32_t image;
+            /** The mipmap level to upload to */
+            uint32_t level;
+            /** The first row to upload */
+            uint32_t row;
+            /** The amount of rows to upload */
+            uint32_t count;
+            /** Offset of the data in the upload buffer */
+            size_t offset;
+            /** The data to upload directly if it doesn't fit in the upload buffer */
+            const char* source;
+        };
+
+        /**
+         * Reads the texture from the given container and starts decoding it in the background
+         *
+         * @param container The container to read the texture from
+         * @param filename The texture to read
+         * @param displaySize The size the texture is displayed at
+         *
+         * @return The texture to use, renders a placeholder until it's ready
+         */
+        const ITexture* load (const CContainer* container, const std::string& filename, glm::uvec2 displaySize);
+        /**
+         * Creates the texture and starts decoding it in the background
+         *
+         * @param filename The texture to read
+         * @param managed The texture's information, the streamed texture is created or replaced
+         * @param reduced Whether only the smallest mipmaps have to be loaded
+         */
+        void stream (const std::string& filename, ManagedTexture& managed, bool reduced = false);
+        /**
+         * Calculates the first mipmap level that still has enough detail for the given display size
+         *
+         * @param texture The texture to check
+         * @param displaySize The size the texture is displayed at, 0 if the full texture is needed
+         *
+         * @return The mipmap level
+         */
+        static uint32_t getBaseLevel (const CTexture* texture, glm::uvec2 displaySize);
+        /**
+         * Places the texture in the atlas if it's small enough and the atlas is enabled,
+         * new pages are only created if they fit in the GPU memory budget
+         *
+         * @param texture The texture to place
+         *
+         * @return If the texture was placed in the atlas
+         */
+        bool placeInAtlas (CTexture* texture);
+        /**
+         * Reloads evicted textures that were used in the last frame and textures that need more detail
+         */
+        void reloadEvicted ();
+        /**
+         * Evicts the least recently used textures until the GPU memory budget is respected,
+         * textures used in the last frame are never evicted. The smallest mipmaps of the evicted
+         * textures are loaded again so they can be rendered until they're reloaded
+         */
+        void enforceBudget ();
+        /**
+         * Uploads the next batch of data for the textures being streamed
+         */
+        void uploadPending ();
+        /**
+         * @return The texture to render while the actual texture is streamed, created on first use
+         */
+        GLuint getPlaceholder ();
+        /**
+         * Creates the buffer used to upload texture data, persistently mapped when supported
+         */
+        void createUploadBuffer ();
+        /**
+         * Frees the upload buffer once the GPU is done reading from it
+         *
+         * @param force Free it even if the GPU is still reading from it, the driver keeps it around until it's done
+         */
+        void releaseUploadBuffer (bool force = false);
+
         /** Cached textures */
         std::map<std::string, const ITexture*> m_textureCache;
+        /** Textures loaded from containers */
+        std::map<std::string, ManagedTexture> m_managed;
+        /** Textures that are still being streamed */
+        std::list<PendingTexture> m_pending;
+        /** The current frame number */
+        uint64_t m_frame;
+        /** Maximum GPU memory the textures can use (in bytes), 0 means no limit */
+        size_t m_budget;
+        /** GPU memory used by the textures */
+        size_t m_residentSize;
+        /** Amount of evictions so far */
+        size_t m_evictions;
+        /** Texture rendered while textures are streamed */
+        GLuint m_placeholder;
+        /** Pixel buffer used to upload texture data */
+        GLuint m_uploadBuffer;
+        /** Persistent mapping of the upload buffer, nullptr if it has to be mapped every frame */
+        char* m_uploadMapping;
+        /** Fences that signal when the GPU is done reading from every segment */
+        GLsync m_fences [UploadSegments];
+        /** The next segment to fill */
+        size_t m_segment;
+        /** Atlas small textures are packed into, nullptr if disabled */
+        CTextureAtlas* m_atlas;
+        /** Whether embedded images are compressed to DXT */
+        bool m_transcode;
     };
 }
@@ -1,4 +1,6 @@
+#include <algorithm>
 #include <sstream>
+#include <glm/common.hpp>
 #include "CImage.h"
 
 using namespace WallpaperEngine;
@@ -91,8 +93,21 @@ CImage::CImage (CScene* scene, Core::Objects::CImage* image) :
         }
         else
         {
+            // the scene is scaled to fit the screens, so take the biggest scale to know how big the image is shown
+            float screenScale = 0.0f;
+
+            for (const auto& cur : this->getContext ().getOutput ()->getViewports ())
+                screenScale = std::max ({
+                    screenScale,
+                    cur.second.viewport.z / scene_width,
+                    cur.second.viewport.w / scene_height
+                });
+
             // get the first texture on the first pass (this one represents the image assigned to this object)
-            this->m_texture = this->getContext ().resolveTexture (textureName);
+            // only loading the mipmaps that can actually be seen on screen
+            this->m_texture = this->getContext ().resolveTexture (
+                textureName, glm::uvec2 (glm::ceil (glm::abs (scaledSize) * screenScale))
+            );
         }
     }
     else
@@ -343,6 +358,42 @@ void CImage::setup ()
     this->m_initialized = true;
 }
 
+void CImage::compilePasses ()
+{
+    if (!this->m_initialized)
+        return;
+
+    try
+    {
+        for (const auto& cur : this->m_passes)
+            cur->compile ();
+    }
+    catch (std::runtime_error& ex)
+    {
+        // the image cannot be rendered without all its passes
+        this->m_initialized = false;
+        throw;
+    }
+}
+
+void CImage::finalizePasses ()
+{
+    if (!this->m_initialized)
+        return;
+
+    try
+    {
+        for (const auto& cur : this->m_passes)
+            cur->finalize ();
+    }
+    catch (std::runtime_error& ex)
+    {
+        // the image cannot be rendered without all its passes
+        this->m_initialized = false;
+        throw;
+    }
+}
+
 void CImage::setupPasses ()
 {
     // do a pass on everything and setup proper inputs and values
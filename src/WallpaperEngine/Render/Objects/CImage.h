@@ -34,6 +34,14 @@ namespace WallpaperEngine::Render::Objects
         CImage (CScene* scene, Core::Objects::CImage* image);
 
         void setup ();
+        /**
+         * Sends the shaders of every pass to the driver, see CPass::compile
+         */
+        void compilePasses ();
+        /**
+         * Finishes the setup of every pass once their shaders are compiled, see CPass::finalize
+         */
+        void finalizePasses ();
         void render () override;
 
         const Core::Objects::CImage* getImage () const;
@@ -17,9 +17,9 @@ void CSound::load ()
     for (const auto& cur : this->m_sound->getSounds ())
     {
         uint32_t filesize = 0;
-        const void* filebuffer = this->getContainer ()->readFile (cur, &filesize);
+        std::shared_ptr <const uint8_t[]> filebuffer = this->getContainer ()->readFile (cur, &filesize);
 
-        auto stream = new Audio::CAudioStream (this->getScene ()->getAudioContext (), filebuffer, filesize);
+        auto stream = new Audio::CAudioStream (this->getScene ()->getAudioContext (), filebuffer.get (), filesize);
 
         stream->setRepeat (this->m_sound->isRepeat ());
 
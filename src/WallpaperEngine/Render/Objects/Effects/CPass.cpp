@@ -1,7 +1,9 @@
 #include "common.h"
+#include <set>
 #include <sstream>
 #include "CPass.h"
 #include "WallpaperEngine/Render/CFBO.h"
+#include "WallpaperEngine/Threading/CThreadPool.h"
 
 #include "WallpaperEngine/Render/Shaders/Variables/CShaderVariable.h"
 #include "WallpaperEngine/Render/Shaders/Variables/CShaderVariableFloat.h"
@@ -29,7 +31,13 @@ CPass::CPass (CMaterial* material, Core::Objects::Images::Materials::CPass* pass
 {
     this->setupTextures ();
     this->setupShaders ();
-    this->setupShaderVariables ();
+}
+
+CPass::~CPass ()
+{
+    // the pre-processing writes to the pass, so it cannot go away before it's done
+    if (this->m_preprocessed.valid ())
+        this->m_preprocessed.wait ();
 }
 
 
@@ -130,35 +138,25 @@ void CPass::render ()
     glm::vec2 translation = {0.0f, 0.0f};
     glm::vec4 rotation = {0.0f, 0.0f, 0.0f, 0.0f};
 
-    if (texture->isAnimated ())
+    if (texture->isAnimated () && texture->getFrameTimeline () != nullptr)
     {
         // calculate current texture and frame
         double currentRenderTime = fmod (static_cast <double> (this->getContext ().getDriver ().getRenderTime ()), this->m_material->getImage ()->getAnimationTime ());
+        const CFrameTimeline::Frame* frame = texture->getFrameTimeline ()->find (currentRenderTime);
 
-        for (const auto& frameCur : texture->getFrames ())
+        // frame found, use it's coordinates
+        if (frame != nullptr)
         {
-            currentRenderTime -= frameCur->frametime;
-
-            if (currentRenderTime <= 0.0f)
-            {
-                // frame found, store coordinates and done
-                currentTexture = frameCur->frameNumber;
-
-                translation.x = frameCur->x / texture->getTextureWidth (currentTexture);
-                translation.y = frameCur->y / texture->getTextureHeight (currentTexture);
-
-                rotation.x = frameCur->width1 / static_cast<float> (texture->getTextureWidth (currentTexture));
-                rotation.y = frameCur->width2 / static_cast<float> (texture->getTextureWidth(currentTexture));
-                rotation.z = frameCur->height2 / static_cast<float> (texture->getTextureHeight (currentTexture));
-                rotation.w = frameCur->height1 / static_cast<float> (texture->getTextureHeight (currentTexture));
-                break;
-            }
+            currentTexture = frame->image;
+            translation = frame->translation;
+            rotation = frame->rotation;
         }
     }
 
     // first texture is a bit special as we have to take what comes from the chain first
     glActiveTexture (GL_TEXTURE0);
     glBindTexture (GL_TEXTURE_2D, texture->getTextureID (currentTexture));
+    this->setAtlasUniforms (0, texture);
 
     // continue on the map from the second texture
     if (!this->m_finalTextures.empty ())
@@ -169,6 +167,7 @@ void CPass::render ()
 
             glActiveTexture (GL_TEXTURE0 + cur.first);
             glBindTexture (GL_TEXTURE_2D, texture->getTextureID (0));
+            this->setAtlasUniforms (cur.first, texture);
         }
     }
 
@@ -321,43 +320,6 @@ Core::Objects::Images::Materials::CPass* CPass::getPass ()
     return this->m_pass;
 }
 
-GLuint CPass::compileShader (Render::Shaders::Compiler* shader, GLuint type)
-{
-    // reserve shaders in OpenGL
-    GLuint shaderID = glCreateShader (type);
-
-    // give shader's source code to OpenGL to be compiled
-    const char* sourcePointer = shader->getCompiled ().c_str ();
-
-    glShaderSource (shaderID, 1, &sourcePointer, nullptr);
-    glCompileShader (shaderID);
-
-    GLint result = GL_FALSE;
-    int infoLogLength = 0;
-
-    // ensure the vertex shader was correctly compiled
-    glGetShaderiv (shaderID, GL_COMPILE_STATUS, &result);
-    glGetShaderiv (shaderID, GL_INFO_LOG_LENGTH, &infoLogLength);
-
-    if (infoLogLength > 0)
-    {
-        char* logBuffer = new char [infoLogLength + 1];
-        // ensure logBuffer ends with a \0
-        memset (logBuffer, 0, infoLogLength + 1);
-        // get information about the error
-        glGetShaderInfoLog (shaderID, infoLogLength, nullptr, logBuffer);
-        // throw an exception about the issue
-        std::stringstream buffer;
-        buffer << logBuffer << std::endl << "Compiled source code:" << std::endl << shader->getCompiled ();
-        // free the buffer
-        delete[] logBuffer;
-        // throw an exception
-        sLog.exception (buffer.str ());
-    }
-
-    return shaderID;
-}
-
 void CPass::setupShaders ()
 {
     // ensure the constants are defined
@@ -376,9 +338,20 @@ void CPass::setupShaders ()
         }
     }
 
+    CContainer* container = this->m_material->getImage ()->getContainer ();
+
+    // pre-processing doesn't touch OpenGL, so it can run in the background while the rest of the scene is set up
+    this->m_preprocessed = Threading::CThreadPool::get ().submit ([this, container] ()
+    {
+        this->preprocessShaders (container);
+    });
+}
+
+void CPass::preprocessShaders (CContainer* container)
+{
     // prepare the shaders
     this->m_fragShader = new Render::Shaders::Compiler (
-        this->m_material->getImage ()->getContainer (),
+        container,
         this->m_pass->getShader (),
         Shaders::Compiler::Type_Pixel,
         this->m_pass->getCombos (),
@@ -388,7 +361,7 @@ void CPass::setupShaders ()
     );
     this->m_fragShader->precompile ();
     this->m_vertShader = new Render::Shaders::Compiler (
-        this->m_material->getImage ()->getContainer (),
+        container,
         this->m_pass->getShader (),
         Shaders::Compiler::Type_Vertex,
         this->m_pass->getCombos (),
@@ -397,52 +370,46 @@ void CPass::setupShaders ()
         this->m_pass->getConstants ()
     );
     this->m_vertShader->precompile ();
-    this->m_fragShader->precompile ();
-    this->m_vertShader->precompile ();
+}
 
-    // compile the shaders
-    GLuint vertexShaderID = compileShader (this->m_vertShader, GL_VERTEX_SHADER);
-    GLuint fragmentShaderID = compileShader (this->m_fragShader, GL_FRAGMENT_SHADER);
-    // create the final program
-    this->m_programID = glCreateProgram ();
-    // link the shaders together
-    glAttachShader (this->m_programID, vertexShaderID);
-    glAttachShader (this->m_programID, fragmentShaderID);
-    glLinkProgram (this->m_programID);
-    // check that the shader was properly linked
-    GLint result = GL_FALSE;
-    int infoLogLength = 0;
-
-    glGetProgramiv (this->m_programID, GL_LINK_STATUS, &result);
-    glGetProgramiv (this->m_programID, GL_INFO_LOG_LENGTH, &infoLogLength);
-
-    if (infoLogLength > 0)
+void CPass::compile ()
+{
+    // errors while pre-processing are thrown here
+    Threading::CThreadPool::get ().wait (this->m_preprocessed);
+
+    // the textures the shaders use are known now, so the samples can be pointed to the atlased ones
+    this->setupFinalTextures ();
+
+    if (this->getContext ().getApp ().getContext ().settings.render.textureAtlas)
     {
-        char* logBuffer = new char [infoLogLength + 1];
-        // ensure logBuffer ends with a \0
-        memset (logBuffer, 0, infoLogLength + 1);
-        // get information about the error
-        glGetProgramInfoLog (this->m_programID, infoLogLength, nullptr, logBuffer);
-        // throw an exception about the issue
-        std::string message = logBuffer;
-        // free the buffer
-        delete[] logBuffer;
-        // throw an exception
-        sLog.exception (message);
-    }
+        uint32_t atlasedUnits = 0;
 
-#if !NDEBUG
-    glObjectLabel (GL_PROGRAM, this->m_programID, -1, this->m_pass->getShader ().c_str ());
-    glObjectLabel (GL_SHADER, vertexShaderID, -1, (this->m_pass->getShader () + ".vert").c_str ());
-    glObjectLabel (GL_SHADER, fragmentShaderID, -1, (this->m_pass->getShader () + ".frag").c_str ());
-#endif /* DEBUG */
+        if (this->resolveTexture (this->m_input, 0, this->m_input)->isAtlased ())
+            atlasedUnits |= 1;
 
-    // after being liked shaders can be dettached and deleted
-    glDetachShader (this->m_programID, vertexShaderID);
-    glDetachShader (this->m_programID, fragmentShaderID);
+        for (const auto& cur : this->m_finalTextures)
+        {
+            const ITexture* texture = this->resolveTexture (cur.second, cur.first, this->m_input);
 
-    glDeleteShader (vertexShaderID);
-    glDeleteShader (fragmentShaderID);
+            if (cur.first >= 0 && cur.first < 32 && texture != nullptr && texture->isAtlased ())
+                atlasedUnits |= 1u << cur.first;
+        }
+
+        this->m_fragShader->setAtlasedUnits (atlasedUnits);
+        this->m_vertShader->setAtlasedUnits (atlasedUnits);
+    }
+
+    // both stages share the found combos, so the code has to be requested after both are pre-processed
+    // passes that end up with the same code share the program
+    this->m_programID = this->getContext ().getProgramCache ()->request (
+        this->m_pass->getShader (), this->m_vertShader->getCompiled (), this->m_fragShader->getCompiled ()
+    );
+}
+
+void CPass::finalize ()
+{
+    // this waits for the driver to finish compiling the program
+    this->getContext ().getProgramCache ()->resolve (this->m_programID);
 
     // setup uniforms
     this->setupUniforms ();
@@ -450,8 +417,68 @@ void CPass::setupShaders ()
     this->setupAttributes ();
     // get information from the program, like uniforms, etc
     // support three textures for now
-    this->g_Texture0Rotation = glGetUniformLocation (this->m_programID, "g_Texture0Rotation");
-    this->g_Texture0Translation = glGetUniformLocation (this->m_programID, "g_Texture0Translation");
+    this->g_Texture0Rotation = this->getUniformLocation ("g_Texture0Rotation");
+    this->g_Texture0Translation = this->getUniformLocation ("g_Texture0Translation");
+
+    for (int index = 0; index < TextureUnits; index ++)
+    {
+        std::string name = "g_Texture" + std::to_string (index);
+
+        this->m_atlasRect [index] = this->getUniformLocation (name + "AtlasRect");
+        this->m_atlasBounds [index] = this->getUniformLocation (name + "AtlasBounds");
+    }
+
+    this->setupShaderVariables ();
+
+#if !NDEBUG
+    this->reportUnusedParameters ();
+#endif /* DEBUG */
+}
+
+void CPass::reportUnusedParameters () const
+{
+    std::set <std::string> unused;
+
+    // the driver removes the uniforms the code doesn't use, so the values given to them are wasted
+    for (const auto* shader : { this->m_vertShader, this->m_fragShader })
+        for (const auto& cur : shader->getParameters ())
+            if (this->getUniformLocation (cur->getName ()) == -1)
+                unused.insert (cur->getName ());
+
+    if (unused.empty ())
+        return;
+
+    std::string list;
+
+    for (const auto& cur : unused)
+        list += " " + cur;
+
+    sLog.debug ("Shader ", this->m_pass->getShader (), " does not use the parameters", list);
+}
+
+void CPass::setAtlasUniforms (int index, const ITexture* texture) const
+{
+    if (index < 0 || index >= TextureUnits || this->m_atlasRect [index] == -1)
+        return;
+
+    const glm::vec4* rect = texture->getAtlasRect ();
+
+    if (rect == nullptr)
+    {
+        // the texture has its own texture, sample it as is
+        glUniform4f (this->m_atlasRect [index], 0.0f, 0.0f, 1.0f, 1.0f);
+        glUniform4f (this->m_atlasBounds [index], -1e20f, -1e20f, 1e20f, 1e20f);
+        return;
+    }
+
+    // keep half a texel away from the borders so filtering doesn't pick up the neighbours
+    glm::vec2 halfTexel = {
+        0.5f / texture->getTextureWidth (),
+        0.5f / texture->getTextureHeight ()
+    };
+
+    glUniform4fv (this->m_atlasRect [index], 1, glm::value_ptr (*rect));
+    glUniform4f (this->m_atlasBounds [index], halfTexel.x, halfTexel.y, 1.0f - halfTexel.x, 1.0f - halfTexel.y);
 }
 
 void CPass::setupAttributes ()
@@ -460,112 +487,113 @@ void CPass::setupAttributes ()
     this->addAttribute ("a_Position", GL_FLOAT, 3, &this->a_Position);
 }
 
-void CPass::setupUniforms ()
+void CPass::setupFinalTextures ()
 {
-    // resolve the main texture
-    const ITexture* texture = this->resolveTexture (this->m_material->getImage ()->getTexture (), 0);
-    // register all the texture uniforms with correct values
-    this->addUniform ("g_Texture0", 0);
-    this->addUniform ("g_Texture1", 1);
-    this->addUniform ("g_Texture2", 2);
-    this->addUniform ("g_Texture3", 3);
-    this->addUniform ("g_Texture4", 4);
-    this->addUniform ("g_Texture5", 5);
-    this->addUniform ("g_Texture6", 6);
-    this->addUniform ("g_Texture7", 7);
-    this->addUniform ("g_Texture0Resolution", texture->getResolution ());
-
     // do the real, final texture setup for the whole process
+    auto cur = this->m_textures.begin ();
+    auto end = this->m_textures.end ();
+    auto fragCur = this->m_fragShader->getTextures ().begin ();
+    auto fragEnd = this->m_fragShader->getTextures ().end ();
+    auto vertCur = this->m_vertShader->getTextures ().begin ();
+    auto vertEnd = this->m_vertShader->getTextures ().end ();
+    auto bindCur = this->m_material->getMaterial ()->getTextureBinds ().begin ();
+    auto bindEnd = this->m_material->getMaterial ()->getTextureBinds ().end ();
+
+    int index = 1;
+
+    // technically m_textures should have the right amount of textures
+    // but better be safe than sorry
+    while (bindCur != bindEnd || cur != end || fragCur != fragEnd || vertCur != vertEnd)
     {
-        auto cur = this->m_textures.begin ();
-        auto end = this->m_textures.end ();
-        auto fragCur = this->m_fragShader->getTextures ().begin ();
-        auto fragEnd = this->m_fragShader->getTextures ().end ();
-        auto vertCur = this->m_vertShader->getTextures ().begin ();
-        auto vertEnd = this->m_vertShader->getTextures ().end ();
-        auto bindCur = this->m_material->getMaterial ()->getTextureBinds ().begin ();
-        auto bindEnd = this->m_material->getMaterial ()->getTextureBinds ().end ();
-
-        int index = 1;
-
-        // technically m_textures should have the right amount of textures
-        // but better be safe than sorry
-        while (bindCur != bindEnd || cur != end || fragCur != fragEnd || vertCur != vertEnd)
+        if (bindCur != bindEnd)
         {
-            if (bindCur != bindEnd)
-            {
-                this->m_finalTextures.insert (std::make_pair ((*bindCur).first, nullptr));
-                bindCur ++;
-            }
+            this->m_finalTextures.insert (std::make_pair ((*bindCur).first, nullptr));
+            bindCur ++;
+        }
 
-            if (cur != end)
-            {
-                if ((*cur) != nullptr)
-                    this->m_finalTextures.insert (std::make_pair (index, *cur));
+        if (cur != end)
+        {
+            if ((*cur) != nullptr)
+                this->m_finalTextures.insert (std::make_pair (index, *cur));
 
-                index ++;
-                cur ++;
-            }
+            index ++;
+            cur ++;
+        }
 
-            if (fragCur != fragEnd)
+        if (fragCur != fragEnd)
+        {
+            std::string textureName = (*fragCur).second;
+
+            try
             {
-                std::string textureName = (*fragCur).second;
+                // resolve the texture first
+                const ITexture* textureRef = nullptr;
 
-                try
+                if (textureName.find ("_rt_") == 0)
                 {
-                    // resolve the texture first
-                    const ITexture* textureRef = nullptr;
-
-                    if (textureName.find ("_rt_") == 0)
-                    {
-                        textureRef = this->getMaterial ()->getEffect ()->findFBO (textureName);
-
-                        if (textureRef == nullptr)
-                            textureRef = this->getMaterial ()->getImage ()->getScene ()->findFBO (textureName);
-                    }
-                    else
-                        textureRef = this->getContext ().resolveTexture (textureName);
+                    textureRef = this->getMaterial ()->getEffect ()->findFBO (textureName);
 
-                    this->m_finalTextures.insert (std::make_pair ((*fragCur).first, textureRef));
-                }
-                catch (std::runtime_error& ex)
-                {
-                    sLog.error ("Cannot resolve texture ", textureName, " for fragment shader ", ex.what ());
+                    if (textureRef == nullptr)
+                        textureRef = this->getMaterial ()->getImage ()->getScene ()->findFBO (textureName);
                 }
+                else
+                    textureRef = this->getContext ().resolveTexture (textureName);
 
-                fragCur ++;
+                this->m_finalTextures.insert (std::make_pair ((*fragCur).first, textureRef));
             }
-
-            if (vertCur != vertEnd)
+            catch (std::runtime_error& ex)
             {
-                std::string textureName = (*vertCur).second;
+                sLog.error ("Cannot resolve texture ", textureName, " for fragment shader ", ex.what ());
+            }
 
-                try
-                {
-                    // resolve the texture first
-                    const ITexture* textureRef = nullptr;
+            fragCur ++;
+        }
 
-                    if (textureName.find ("_rt_") == 0)
-                    {
-                        textureRef = this->getMaterial ()->getEffect ()->findFBO (textureName);
+        if (vertCur != vertEnd)
+        {
+            std::string textureName = (*vertCur).second;
 
-                        if (textureRef == nullptr)
-                            textureRef = this->getMaterial ()->getImage ()->getScene ()->findFBO (textureName);
-                    }
-                    else
-                        textureRef = this->getContext ().resolveTexture (textureName);
+            try
+            {
+                // resolve the texture first
+                const ITexture* textureRef = nullptr;
 
-                    this->m_finalTextures.insert (std::make_pair ((*vertCur).first, textureRef));
-                }
-                catch (std::runtime_error& ex)
+                if (textureName.find ("_rt_") == 0)
                 {
-                    sLog.error ("Cannot resolve texture ", textureName, " for vertex shader ", ex.what ());
+                    textureRef = this->getMaterial ()->getEffect ()->findFBO (textureName);
+
+                    if (textureRef == nullptr)
+                        textureRef = this->getMaterial ()->getImage ()->getScene ()->findFBO (textureName);
                 }
+                else
+                    textureRef = this->getContext ().resolveTexture (textureName);
 
-                vertCur ++;
+                this->m_finalTextures.insert (std::make_pair ((*vertCur).first, textureRef));
+            }
+            catch (std::runtime_error& ex)
+            {
+                sLog.error ("Cannot resolve texture ", textureName, " for vertex shader ", ex.what ());
             }
+
+            vertCur ++;
         }
     }
+}
+
+void CPass::setupUniforms ()
+{
+    // resolve the main texture
+    const ITexture* texture = this->resolveTexture (this->m_material->getImage ()->getTexture (), 0);
+    // register all the texture uniforms with correct values
+    this->addUniform ("g_Texture0", 0);
+    this->addUniform ("g_Texture1", 1);
+    this->addUniform ("g_Texture2", 2);
+    this->addUniform ("g_Texture3", 3);
+    this->addUniform ("g_Texture4", 4);
+    this->addUniform ("g_Texture5", 5);
+    this->addUniform ("g_Texture6", 6);
+    this->addUniform ("g_Texture7", 7);
+    this->addUniform ("g_Texture0Resolution", texture->getResolution ());
 
     for (const auto& cur : this->m_finalTextures)
     {
@@ -586,7 +614,8 @@ void CPass::setupUniforms ()
     this->addUniform ("g_Color", this->m_material->getImage ()->getImage ()->getColor ());
     // TODO: VALIDATE THAT G_COMPOSITECOLOR REALLY COMES FROM THIS ONE
     this->addUniform ("g_CompositeColor", this->m_material->getImage ()->getImage ()->getColor ());
-    // add some external variables
+    // add some external variables, these usually come from the frame globals block and are not set here
+    // unless the shader declares them with a different type
     this->addUniform ("g_Time", &g_Time);
     // add model-view-projection matrix
     this->addUniform ("g_ModelViewProjectionMatrix", &this->m_modelViewProjectionMatrix);
@@ -604,6 +633,11 @@ void CPass::setupUniforms ()
     this->addUniform ("g_AudioSpectrum64Right", this->getMaterial ()->getImage ()->getScene ()->getAudioContext ().getRecorder ().audio64, 64);
 }
 
+GLint CPass::getUniformLocation (const std::string& name) const
+{
+    return this->getContext ().getProgramCache ()->getUniformLocation (this->m_programID, name);
+}
+
 void CPass::addAttribute (const std::string& name, GLint type, GLint elements, const GLuint* value)
 {
     GLint id = glGetAttribLocation (this->m_programID, name.c_str ());
@@ -619,7 +653,7 @@ void CPass::addAttribute (const std::string& name, GLint type, GLint elements, c
 template <typename T>
 void CPass::addUniform (const std::string& name, UniformType type, T value)
 {
-    GLint id = glGetUniformLocation (this->m_programID, name.c_str ());
+    GLint id = this->getUniformLocation (name);
 
     // parameter not found, can be ignored
     if (id == -1)
@@ -638,7 +672,7 @@ template <typename T>
 void CPass::addUniform (const std::string& name, UniformType type, T* value, int count)
 {
     // this version is used to reference to system variables so things like g_Time works fine
-    GLint id = glGetUniformLocation (this->m_programID, name.c_str ());
+    GLint id = this->getUniformLocation (name);
 
     // parameter not found, can be ignored
     if (id == -1)
@@ -654,7 +688,7 @@ template <typename T>
 void CPass::addUniform (const std::string& name, UniformType type, T** value)
 {
     // this version is used to reference to system variables so things like g_Time works fine
-    GLint id = glGetUniformLocation (this->m_programID, name.c_str ());
+    GLint id = this->getUniformLocation (name);
 
     // parameter not found, can be ignored
     if (id == -1)
@@ -1,6 +1,7 @@
 #pragma once
 
 #include <glm/gtc/type_ptr.hpp>
+#include <future>
 #include <utility>
 
 #include "WallpaperEngine/Render/Shaders/Variables/CShaderVariable.h"
@@ -24,6 +25,21 @@ namespace WallpaperEngine::Render::Objects::Effects
     {
     public:
         CPass (CMaterial* material, Core::Objects::Images::Materials::CPass* pass);
+        /**
+         * Waits for the shaders to be pre-processed if they're still in the thread pool
+         */
+        ~CPass ();
+
+        /**
+         * Sends the pass' shaders to the driver once they're pre-processed, the result
+         * is not checked so the driver can compile the shaders of multiple passes at the same time
+         */
+        void compile ();
+        /**
+         * Waits for the pass' program to be ready and looks up its uniforms and attributes,
+         * must be called after compile
+         */
+        void finalize ();
 
         void render ();
 
@@ -87,13 +103,27 @@ namespace WallpaperEngine::Render::Objects::Effects
             const GLuint* value;
         };
 
-        static GLuint compileShader (Render::Shaders::Compiler* shader, GLuint type);
         void setupTextures ();
         void setupShaders ();
+        /**
+         * Pre-processes the pass' shaders, runs in the thread pool
+         *
+         * @param container The container to load the shaders from
+         */
+        void preprocessShaders (CContainer* container);
         void setupShaderVariables ();
+        /**
+         * Resolves the textures bound to every unit the pass uses
+         */
+        void setupFinalTextures ();
         void setupUniforms ();
         void setupAttributes ();
         void addAttribute (const std::string& name, GLint type, GLint elements, const GLuint* value);
+        GLint getUniformLocation (const std::string& name) const;
+        /**
+         * Logs the parameters declared by the shaders that the linked program doesn't use
+         */
+        void reportUnusedParameters () const;
         void addUniform (CShaderVariable* value);
         void addUniform (const std::string& name, CShaderConstant* value);
         void addUniform (const std::string& name, int value);
@@ -122,6 +152,13 @@ namespace WallpaperEngine::Render::Objects::Effects
         template <typename T> void addUniform (const std::string& name, UniformType type, T** value);
 
         const ITexture* resolveTexture (const ITexture* expected, int index, const ITexture* previous = nullptr);
+        /**
+         * Tells the shader where the texture bound to the given unit is in its atlas (if any)
+         *
+         * @param index The texture unit
+         * @param texture The texture bound to it
+         */
+        void setAtlasUniforms (int index, const ITexture* texture) const;
 
         CMaterial* m_material;
         Core::Objects::Images::Materials::CPass* m_pass;
@@ -141,12 +178,21 @@ namespace WallpaperEngine::Render::Objects::Effects
 
         Render::Shaders::Compiler* m_fragShader;
         Render::Shaders::Compiler* m_vertShader;
+        /** Finishes once both shaders are pre-processed */
+        std::future <void> m_preprocessed;
 
         const CFBO* m_drawTo;
         const ITexture* m_input;
 
         GLuint m_programID;
 
+        /** Amount of texture units the pass can use */
+        static constexpr int TextureUnits = 8;
+        /** Location of the atlas region of every texture unit, -1 if atlases are not in use */
+        GLint m_atlasRect [TextureUnits];
+        /** Location of the clamping bounds of every texture unit, -1 if atlases are not in use */
+        GLint m_atlasBounds [TextureUnits];
+
         // shader variables used temporary
         GLint g_Texture0Rotation;
         GLint g_Texture0Translation;
@@ -0,0 +1,132 @@
+#include "AtlasSampling.h"
+
+#include <cctype>
+
+namespace WallpaperEngine::Render::Shaders::AtlasSampling
+{
+    static bool isIdentifierChar (char c)
+    {
+        return isalnum (static_cast <unsigned char> (c)) || c == '_';
+    }
+
+    static size_t skipSpaces (std::string_view code, size_t position)
+    {
+        while (position < code.size () && isspace (static_cast <unsigned char> (code [position])))
+            position ++;
+
+        return position;
+    }
+
+    std::string getDeclarations (uint32_t units)
+    {
+        if (units == 0)
+            return "";
+
+        // the coordinates are clamped to the region to emulate GL_CLAMP_TO_EDGE on the texture's borders
+        std::string result =
+            "vec2 atlasCoord (vec4 rect, vec4 bounds, vec2 uv) { return rect.xy + clamp (uv, bounds.xy, bounds.zw) * rect.zw; }\n"
+            "vec4 atlasSample2D (sampler2D s, vec4 rect, vec4 bounds, vec2 uv) { return texture (s, atlasCoord (rect, bounds, uv)); }\n"
+            "vec4 atlasSample2DLod (sampler2D s, vec4 rect, vec4 bounds, vec2 uv, float lod) { return textureLod (s, atlasCoord (rect, bounds, uv), lod); }\n";
+
+        for (int unit = 0; unit < 32; unit ++)
+        {
+            if ((units & (1u << unit)) == 0)
+                continue;
+
+            std::string name = "g_Texture" + std::to_string (unit);
+
+            result += "uniform vec4 " + name + "AtlasRect;\n";
+            result += "uniform vec4 " + name + "AtlasBounds;\n";
+        }
+
+        return result + "\n";
+    }
+
+    std::string rewriteSamples (std::string_view code, uint32_t units)
+    {
+        static constexpr std::string_view function = "texSample2D";
+        static constexpr std::string_view sampler = "g_Texture";
+
+        if (units == 0)
+            return std::string (code);
+
+        std::string result;
+        size_t copied = 0;
+        size_t position = 0;
+
+        result.reserve (code.size () + code.size () / 8);
+
+        while ((position = code.find (function, position)) != std::string_view::npos)
+        {
+            size_t start = position;
+            size_t cur = position + function.size ();
+
+            position = cur;
+
+            // only whole identifiers, texSample2D or texSample2DLod
+            if (start > 0 && isIdentifierChar (code [start - 1]))
+                continue;
+
+            bool lod = code.substr (cur, 3) == "Lod";
+
+            if (lod)
+                cur += 3;
+
+            if (cur < code.size () && isIdentifierChar (code [cur]))
+                continue;
+
+            cur = skipSpaces (code, cur);
+
+            if (cur >= code.size () || code [cur] != '(')
+                continue;
+
+            cur = skipSpaces (code, cur + 1);
+
+            // the first argument has to be one of the pass' samplers
+            if (code.substr (cur, sampler.size ()) != sampler)
+                continue;
+
+            size_t nameStart = cur;
+
+            cur += sampler.size ();
+
+            size_t digitsStart = cur;
+            int unit = 0;
+
+            while (cur < code.size () && isdigit (static_cast <unsigned char> (code [cur])) && cur - digitsStart < 2)
+                unit = unit * 10 + (code [cur ++] - '0');
+
+            if (cur == digitsStart || unit >= 32 || (cur < code.size () && isIdentifierChar (code [cur])))
+                continue;
+
+            if ((units & (1u << unit)) == 0)
+                continue;
+
+            size_t nameEnd = cur;
+
+            cur = skipSpaces (code, cur);
+
+            if (cur >= code.size () || code [cur] != ',')
+                continue;
+
+            std::string_view name = code.substr (nameStart, nameEnd - nameStart);
+
+            // the rest of the arguments are kept as they are
+            result.append (code.substr (copied, start - copied));
+            result += lod ? "atlasSample2DLod (" : "atlasSample2D (";
+            result.append (name);
+            result += ", ";
+            result.append (name);
+            result += "AtlasRect, ";
+            result.append (name);
+            result += "AtlasBounds";
+
+            copied = nameEnd;
+            position = nameEnd;
+        }
+
+        result.append (code.substr (copied));
+
+        return result;
+    }
+}
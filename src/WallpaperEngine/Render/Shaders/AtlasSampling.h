@@ -0,0 +1,30 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+namespace WallpaperEngine::Render::Shaders::AtlasSampling
+{
+    /**
+     * Builds the helper functions and the region uniforms (g_TextureNAtlasRect and g_TextureNAtlasBounds)
+     * the rewritten samples need
+     *
+     * @param units Bit mask of the texture units that are bound to an atlased texture
+     *
+     * @return The GLSL declarations, empty if no unit is atlased
+     */
+    std::string getDeclarations (uint32_t units);
+
+    /**
+     * Rewrites the texSample2D and texSample2DLod calls that sample one of the given units so the coordinates
+     * are mapped to the texture's region in the atlas. The sampler declarations and any other use of
+     * the samplers (textureSize, texelFetch, function arguments...) are left as they are
+     *
+     * @param code The pre-processed shader code
+     * @param units Bit mask of the texture units that are bound to an atlased texture
+     *
+     * @return The rewritten code
+     */
+    std::string rewriteSamples (std::string_view code, uint32_t units);
+}
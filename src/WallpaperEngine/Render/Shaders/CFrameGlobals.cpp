@@ -0,0 +1,120 @@
+#include "common.h"
+#include "CFrameGlobals.h"
+
+#include <cstddef>
+
+using namespace WallpaperEngine::Render::Shaders;
+
+/**
+ * An uniform in the block
+ */
+struct FrameGlobalsMember
+{
+    const char* type;
+    const char* name;
+    const char* array;
+};
+
+/** The uniforms in the block, in the same order as CFrameGlobals::Data */
+static const FrameGlobalsMember FRAME_GLOBALS_MEMBERS [] = {
+    { "float", "g_Time", "" },
+    { "vec2", "g_PointerPosition", "" },
+    { "vec2", "g_PointerPositionLast", "" },
+    { "vec2", "g_TexelSize", "" },
+    { "vec2", "g_TexelSizeHalf", "" },
+    { "float", "g_AudioSpectrum16Left", "[16]" },
+    { "float", "g_AudioSpectrum16Right", "[16]" },
+    { "float", "g_AudioSpectrum32Left", "[32]" },
+    { "float", "g_AudioSpectrum32Right", "[32]" },
+    { "float", "g_AudioSpectrum64Left", "[64]" },
+    { "float", "g_AudioSpectrum64Right", "[64]" },
+};
+
+CFrameGlobals::CFrameGlobals () :
+    m_buffer (0),
+    m_data ()
+{
+    // the offsets std140 gives to the members of the block
+    static_assert (offsetof (Data, pointerPosition) == 8);
+    static_assert (offsetof (Data, texelSizeHalf) == 32);
+    static_assert (offsetof (Data, audioSpectrum16Left) == 48);
+    static_assert (offsetof (Data, audioSpectrum32Left) == 560);
+    static_assert (offsetof (Data, audioSpectrum64Left) == 1584);
+    static_assert (sizeof (Data) == 3632);
+
+    glGenBuffers (1, &this->m_buffer);
+    glBindBuffer (GL_UNIFORM_BUFFER, this->m_buffer);
+    glBufferData (GL_UNIFORM_BUFFER, sizeof (Data), nullptr, GL_DYNAMIC_DRAW);
+    glBindBuffer (GL_UNIFORM_BUFFER, 0);
+
+#if !NDEBUG
+    glObjectLabel (GL_BUFFER, this->m_buffer, -1, "g_FrameGlobals");
+#endif /* DEBUG */
+}
+
+CFrameGlobals::~CFrameGlobals ()
+{
+    glDeleteBuffers (1, &this->m_buffer);
+}
+
+void CFrameGlobals::update (
+    float time, glm::vec2 pointerPosition, glm::vec2 pointerPositionLast, glm::vec2 texelSize,
+    const Audio::Drivers::Recorders::CPlaybackRecorder& recorder
+)
+{
+    this->m_data.time = time;
+    this->m_data.pointerPosition = pointerPosition;
+    this->m_data.pointerPositionLast = pointerPositionLast;
+    this->m_data.texelSize = texelSize;
+    this->m_data.texelSizeHalf = texelSize * 0.5f;
+
+    // there's only one channel recorded, both sides get the same values
+    for (int i = 0; i < 16; i ++)
+        this->m_data.audioSpectrum16Left [i].x = this->m_data.audioSpectrum16Right [i].x = recorder.audio16 [i];
+    for (int i = 0; i < 32; i ++)
+        this->m_data.audioSpectrum32Left [i].x = this->m_data.audioSpectrum32Right [i].x = recorder.audio32 [i];
+    for (int i = 0; i < 64; i ++)
+        this->m_data.audioSpectrum64Left [i].x = this->m_data.audioSpectrum64Right [i].x = recorder.audio64 [i];
+
+    glBindBuffer (GL_UNIFORM_BUFFER, this->m_buffer);
+    glBufferSubData (GL_UNIFORM_BUFFER, 0, sizeof (Data), &this->m_data);
+    glBindBuffer (GL_UNIFORM_BUFFER, 0);
+}
+
+void CFrameGlobals::bind () const
+{
+    glBindBufferBase (GL_UNIFORM_BUFFER, Binding, this->m_buffer);
+}
+
+const std::string& CFrameGlobals::getDeclaration ()
+{
+    static const std::string declaration = [] ()
+    {
+        std::string result = "layout (std140) uniform FrameGlobals\n{\n";
+
+        for (const auto& cur : FRAME_GLOBALS_MEMBERS)
+            result += std::string ("    ") + cur.type + " " + cur.name + cur.array + ";\n";
+
+        return result + "} g_FrameGlobals;\n\n";
+    } ();
+
+    return declaration;
+}
+
+bool CFrameGlobals::isMember (const std::string& type, const std::string& name, const std::string& array)
+{
+    for (const auto& cur : FRAME_GLOBALS_MEMBERS)
+        if (name == cur.name)
+            return type == cur.type && array == cur.array;
+
+    return false;
+}
+
+void CFrameGlobals::setupProgram (GLuint program)
+{
+    GLuint index = glGetUniformBlockIndex (program, "FrameGlobals");
+
+    // the block is removed if the code doesn't use any of the values
+    if (index != GL_INVALID_INDEX)
+        glUniformBlockBinding (program, index, Binding);
+}
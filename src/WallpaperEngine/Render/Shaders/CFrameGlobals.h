@@ -0,0 +1,94 @@
+#pragma once
+
+#include <GL/glew.h>
+#include <string>
+#include <glm/vec2.hpp>
+#include <glm/vec4.hpp>
+
+#include "WallpaperEngine/Audio/Drivers/Recorders/CPlaybackRecorder.h"
+
+namespace WallpaperEngine::Render::Shaders
+{
+    /**
+     * Uniforms that have the same value for every pass in a frame (time, pointer, audio spectrum...)
+     * kept in an uniform buffer that is updated once per frame instead of being set on every pass.
+     *
+     * The shader compiler turns the declarations of these uniforms into references to the
+     * g_FrameGlobals block, declarations with a different type are left as regular uniforms
+     */
+    class CFrameGlobals
+    {
+    public:
+        /** Binding point of the block in every program */
+        static constexpr GLuint Binding = 0;
+
+        CFrameGlobals ();
+        ~CFrameGlobals ();
+
+        /**
+         * Uploads the values for the current frame
+         *
+         * @param time The current time
+         * @param pointerPosition The pointer position for this frame
+         * @param pointerPositionLast The pointer position on the previous frame
+         * @param texelSize The size of a texel of the scene
+         * @param recorder The audio spectrum
+         */
+        void update (
+            float time, glm::vec2 pointerPosition, glm::vec2 pointerPositionLast, glm::vec2 texelSize,
+            const Audio::Drivers::Recorders::CPlaybackRecorder& recorder
+        );
+        /**
+         * Binds the buffer to the block's binding point
+         */
+        void bind () const;
+
+        /**
+         * @return The GLSL declaration of the block
+         */
+        static const std::string& getDeclaration ();
+        /**
+         * Checks if the given uniform declaration is part of the block
+         *
+         * @param type The type of the uniform
+         * @param name The name of the uniform
+         * @param array The array size indicator of the uniform (if any)
+         *
+         * @return If the uniform can be read from the block
+         */
+        static bool isMember (const std::string& type, const std::string& name, const std::string& array);
+        /**
+         * Points the program's block (if it uses it) to the block's binding point
+         *
+         * @param program The linked program
+         */
+        static void setupProgram (GLuint program);
+
+    private:
+        /**
+         * Contents of the block following the std140 rules, elements of float arrays take 16 bytes,
+         * must be kept in sync with the declaration
+         */
+        struct Data
+        {
+            float time;
+            float padding0;
+            glm::vec2 pointerPosition;
+            glm::vec2 pointerPositionLast;
+            glm::vec2 texelSize;
+            glm::vec2 texelSizeHalf;
+            glm::vec2 padding1;
+            glm::vec4 audioSpectrum16Left [16];
+            glm::vec4 audioSpectrum16Right [16];
+            glm::vec4 audioSpectrum32Left [32];
+            glm::vec4 audioSpectrum32Right [32];
+            glm::vec4 audioSpectrum64Left [64];
+            glm::vec4 audioSpectrum64Right [64];
+        };
+
+        /** The uniform buffer */
+        GLuint m_buffer;
+        /** Copy of the buffer's contents */
+        Data m_data;
+    };
+}
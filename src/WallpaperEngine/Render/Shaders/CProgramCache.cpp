@@ -0,0 +1,488 @@
+#include "common.h"
+#include "CProgramCache.h"
+#include "CFrameGlobals.h"
+
+#include "WallpaperEngine/FileSystem/FileSystem.h"
+
+#include <atomic>
+#include <cstdio>
+#include <cstring>
+#include <sstream>
+#include <vector>
+#include <unistd.h>
+
+using namespace WallpaperEngine::Render::Shaders;
+
+/**
+ * Header of the program binaries stored in the cache
+ */
+struct ProgramBinaryHeader
+{
+    char magic [8];
+    uint64_t sourceHash;
+    uint64_t driverHash;
+    WallpaperEngine::FileSystem::Digest sourceDigest;
+    uint32_t format;
+    uint32_t length;
+};
+
+static const char PROGRAM_BINARY_MAGIC [8] = { 'W', 'P', 'G', 'L', 'B', 'I', 'N', '2' };
+
+CProgramCache::CProgramCache ()
+{
+    // let the driver use as many threads as it wants, programs are only checked after all of them were requested
+    if (GLEW_KHR_parallel_shader_compile)
+        glMaxShaderCompilerThreadsKHR (0xFFFFFFFF);
+}
+
+CProgramCache::~CProgramCache ()
+{
+    for (const auto& [program, pending] : this->m_pending)
+    {
+        glDeleteShader (pending.vertexShader);
+        glDeleteShader (pending.fragmentShader);
+    }
+
+    for (const auto& [hash, cached] : this->m_programs)
+        glDeleteProgram (cached.program);
+
+    for (const auto& [program, error] : this->m_failed)
+        glDeleteProgram (program);
+}
+
+GLuint CProgramCache::get (const std::string& name, const std::string& vertex, const std::string& fragment)
+{
+    GLuint program = this->request (name, vertex, fragment);
+
+    this->resolve (program);
+
+    return program;
+}
+
+GLuint CProgramCache::request (const std::string& name, const std::string& vertex, const std::string& fragment)
+{
+    uint64_t vertexHash = WallpaperEngine::FileSystem::contentHash (vertex.data (), vertex.size ());
+    uint64_t fragmentHash = WallpaperEngine::FileSystem::contentHash (fragment.data (), fragment.size ());
+    // the order matters, so the hashes can't be simply xor'ed
+    uint64_t hash = vertexHash ^ (fragmentHash + 0x9E3779B97F4A7C15ULL + (vertexHash << 6) + (vertexHash >> 2));
+
+    auto range = this->m_programs.equal_range (hash);
+
+    // different sources can end up with the same hash
+    for (auto cur = range.first; cur != range.second; cur ++)
+    {
+        if (cur->second.vertex != vertex || cur->second.fragment != fragment)
+            continue;
+
+        this->m_hits ++;
+        return cur->second.program;
+    }
+
+    GLuint program = this->loadBinary (hash, vertex, fragment);
+
+    if (program != 0)
+    {
+        CFrameGlobals::setupProgram (program);
+
+        this->m_programs.insert (std::make_pair (hash, CachedProgram {vertex, fragment, program}));
+
+        sLog.debug ("Loaded shader program ", name, " from the program cache");
+
+        return program;
+    }
+
+    // nothing is checked here so the driver doesn't have to finish compiling before the next program is requested
+    PendingProgram pending {
+        name, vertex, fragment,
+        compileShader (vertex, GL_VERTEX_SHADER),
+        compileShader (fragment, GL_FRAGMENT_SHADER),
+        hash
+    };
+
+    program = link (pending.vertexShader, pending.fragmentShader);
+
+    this->m_programs.insert (std::make_pair (hash, CachedProgram {vertex, fragment, program}));
+    this->m_pending.insert (std::make_pair (program, std::move (pending)));
+
+    return program;
+}
+
+void CProgramCache::resolve (GLuint program)
+{
+    // passes that share a program that didn't compile have to fail too
+    auto failed = this->m_failed.find (program);
+
+    if (failed != this->m_failed.end ())
+        sLog.exception (failed->second);
+
+    auto found = this->m_pending.find (program);
+
+    if (found == this->m_pending.end ())
+        return;
+
+    // take it out of the list first, the checks throw on errors
+    PendingProgram pending = std::move (found->second);
+
+    this->m_pending.erase (found);
+
+    try
+    {
+        checkProgram (pending, program);
+    }
+    catch (std::runtime_error& e)
+    {
+        // the program is useless, make new requests for the same sources try again
+        auto range = this->m_programs.equal_range (pending.hash);
+
+        for (auto cur = range.first; cur != range.second; cur ++)
+        {
+            if (cur->second.program != program)
+                continue;
+
+            this->m_programs.erase (cur);
+            break;
+        }
+
+        glDetachShader (program, pending.vertexShader);
+        glDetachShader (program, pending.fragmentShader);
+        glDeleteShader (pending.vertexShader);
+        glDeleteShader (pending.fragmentShader);
+
+        // passes that got the same program before it failed have to know about it, the program itself is
+        // kept around so OpenGL doesn't hand out its name to a different program while they still hold it
+        this->m_failed.insert (std::make_pair (program, e.what ()));
+        throw;
+    }
+
+    CFrameGlobals::setupProgram (program);
+
+    this->saveBinary (pending.hash, pending.vertex, pending.fragment, program);
+
+    sLog.debug ("Compiled shader program ", pending.name, " (", this->m_programs.size (), " programs, ", this->m_hits, " reused)");
+}
+
+GLint CProgramCache::getUniformLocation (GLuint program, const std::string& name)
+{
+    const auto& uniforms = this->getUniforms (program);
+    auto found = uniforms.find (name);
+
+    if (found == uniforms.end ())
+        return -1;
+
+    return found->second;
+}
+
+const std::map <std::string, GLint>& CProgramCache::getUniforms (GLuint program)
+{
+    auto found = this->m_uniforms.find (program);
+
+    if (found != this->m_uniforms.end ())
+        return found->second;
+
+    auto& uniforms = this->m_uniforms [program];
+    GLint count = 0;
+    GLint maxLength = 0;
+
+    glGetProgramiv (program, GL_ACTIVE_UNIFORMS, &count);
+    glGetProgramiv (program, GL_ACTIVE_UNIFORM_MAX_LENGTH, &maxLength);
+
+    std::vector <char> buffer (maxLength + 1);
+
+    for (GLint index = 0; index < count; index ++)
+    {
+        GLsizei length = 0;
+        GLint size = 0;
+        GLenum type = 0;
+
+        glGetActiveUniform (program, index, buffer.size (), &length, &size, &type, buffer.data ());
+
+        std::string name (buffer.data (), length);
+        GLint location = glGetUniformLocation (program, name.c_str ());
+
+        // uniforms inside blocks do not have a location
+        if (location == -1)
+            continue;
+
+        uniforms.insert (std::make_pair (name, location));
+
+        // arrays are reported as their first element, but are set through their name
+        if (name.size () > 3 && name.compare (name.size () - 3, 3, "[0]") == 0)
+            uniforms.insert (std::make_pair (name.substr (0, name.size () - 3), location));
+    }
+
+    return uniforms;
+}
+
+size_t CProgramCache::getProgramCount () const
+{
+    return this->m_programs.size ();
+}
+
+size_t CProgramCache::getHitCount () const
+{
+    return this->m_hits;
+}
+
+GLuint CProgramCache::compileShader (const std::string& source, GLenum type)
+{
+    // reserve shaders in OpenGL
+    GLuint shaderID = glCreateShader (type);
+
+    // give shader's source code to OpenGL to be compiled
+    const char* sourcePointer = source.c_str ();
+
+    glShaderSource (shaderID, 1, &sourcePointer, nullptr);
+    glCompileShader (shaderID);
+
+    return shaderID;
+}
+
+void CProgramCache::checkShader (const std::string& name, GLuint shader, const std::string& source, GLenum type)
+{
+    GLint result = GL_FALSE;
+    int infoLogLength = 0;
+
+    // ensure the shader was correctly compiled
+    glGetShaderiv (shader, GL_COMPILE_STATUS, &result);
+    glGetShaderiv (shader, GL_INFO_LOG_LENGTH, &infoLogLength);
+
+    if (infoLogLength > 0)
+    {
+        char* logBuffer = new char [infoLogLength + 1];
+        // ensure logBuffer ends with a \0
+        memset (logBuffer, 0, infoLogLength + 1);
+        // get information about the error
+        glGetShaderInfoLog (shader, infoLogLength, nullptr, logBuffer);
+        // throw an exception about the issue
+        std::stringstream buffer;
+        buffer << logBuffer << std::endl << "Compiled source code:" << std::endl << source;
+        // free the buffer
+        delete[] logBuffer;
+        // throw an exception
+        sLog.exception (buffer.str ());
+    }
+
+#if !NDEBUG
+    glObjectLabel (GL_SHADER, shader, -1, (name + (type == GL_VERTEX_SHADER ? ".vert" : ".frag")).c_str ());
+#endif /* DEBUG */
+}
+
+GLuint CProgramCache::link (GLuint vertexShader, GLuint fragmentShader)
+{
+    // create the final program
+    GLuint programID = glCreateProgram ();
+    // the binary has to be retrievable so it can be stored on disk
+    if (GLEW_ARB_get_program_binary)
+        glProgramParameteri (programID, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+    // link the shaders together
+    glAttachShader (programID, vertexShader);
+    glAttachShader (programID, fragmentShader);
+    glLinkProgram (programID);
+
+    return programID;
+}
+
+void CProgramCache::checkProgram (const PendingProgram& pending, GLuint program)
+{
+    // the shaders' status is only known now, errors there are more useful than the link error
+    checkShader (pending.name, pending.vertexShader, pending.vertex, GL_VERTEX_SHADER);
+    checkShader (pending.name, pending.fragmentShader, pending.fragment, GL_FRAGMENT_SHADER);
+
+    // check that the shader was properly linked
+    GLint result = GL_FALSE;
+    int infoLogLength = 0;
+
+    glGetProgramiv (program, GL_LINK_STATUS, &result);
+    glGetProgramiv (program, GL_INFO_LOG_LENGTH, &infoLogLength);
+
+    if (infoLogLength > 0)
+    {
+        char* logBuffer = new char [infoLogLength + 1];
+        // ensure logBuffer ends with a \0
+        memset (logBuffer, 0, infoLogLength + 1);
+        // get information about the error
+        glGetProgramInfoLog (program, infoLogLength, nullptr, logBuffer);
+        // throw an exception about the issue
+        std::string message = logBuffer;
+        // free the buffer
+        delete[] logBuffer;
+        // throw an exception
+        sLog.exception (message);
+    }
+
+#if !NDEBUG
+    glObjectLabel (GL_PROGRAM, program, -1, pending.name.c_str ());
+#endif /* DEBUG */
+
+    // after being liked shaders can be dettached and deleted
+    glDetachShader (program, pending.vertexShader);
+    glDetachShader (program, pending.fragmentShader);
+
+    glDeleteShader (pending.vertexShader);
+    glDeleteShader (pending.fragmentShader);
+}
+
+std::filesystem::path CProgramCache::getBinaryPath (uint64_t hash)
+{
+    if (!this->m_binariesChecked)
+    {
+        this->m_binariesChecked = true;
+
+        GLint formats = 0;
+
+        if (GLEW_ARB_get_program_binary)
+            glGetIntegerv (GL_NUM_PROGRAM_BINARY_FORMATS, &formats);
+
+        // some drivers expose the extension without any format to store binaries in
+        if (formats == 0)
+            return {};
+
+        try
+        {
+            this->m_binaryDirectory = WallpaperEngine::FileSystem::cacheDirectory ("shaders");
+            // drivers get updated and shaders change, so binaries that are not used anymore pile up
+            WallpaperEngine::FileSystem::pruneCacheDirectory (this->m_binaryDirectory, ".glbin", BinaryCacheBudget);
+        }
+        catch (std::exception& e)
+        {
+            sLog.error ("Cannot use shader program cache: ", e.what ());
+            return {};
+        }
+
+        // binaries are only valid for the exact same driver
+        std::string driver;
+
+        for (GLenum cur : { GL_VENDOR, GL_RENDERER, GL_VERSION })
+        {
+            const auto* value = reinterpret_cast <const char*> (glGetString (cur));
+
+            driver += value != nullptr ? value : "";
+            driver += '\n';
+        }
+
+        this->m_driverHash = WallpaperEngine::FileSystem::contentHash (driver.data (), driver.size ());
+        this->m_binariesEnabled = true;
+    }
+
+    if (!this->m_binariesEnabled)
+        return {};
+
+    char filename [48];
+
+    snprintf (
+        filename, sizeof (filename), "%016llx-%016llx.glbin",
+        static_cast <unsigned long long> (hash), static_cast <unsigned long long> (this->m_driverHash)
+    );
+
+    return this->m_binaryDirectory / filename;
+}
+
+GLuint CProgramCache::loadBinary (uint64_t hash, const std::string& vertex, const std::string& fragment)
+{
+    std::filesystem::path path = this->getBinaryPath (hash);
+
+    if (path.empty ())
+        return 0;
+
+    FILE* fp = fopen (path.c_str (), "rb");
+
+    if (fp == nullptr)
+        return 0;
+
+    ProgramBinaryHeader header {};
+    std::vector <char> binary;
+
+    bool valid = fread (&header, sizeof (header), 1, fp) == 1 &&
+        memcmp (header.magic, PROGRAM_BINARY_MAGIC, sizeof (PROGRAM_BINARY_MAGIC)) == 0 &&
+        header.sourceHash == hash &&
+        header.driverHash == this->m_driverHash &&
+        header.length > 0;
+
+    // the hash only names the file, the digest makes sure it's for the exact same sources
+    if (valid)
+        valid = header.sourceDigest == WallpaperEngine::FileSystem::contentDigest ({vertex, fragment});
+
+    if (valid)
+    {
+        binary.resize (header.length);
+        valid = fread (binary.data (), header.length, 1, fp) == 1;
+    }
+
+    fclose (fp);
+
+    if (!valid)
+    {
+        sLog.debug ("Ignoring invalid shader program cache file ", path);
+        return 0;
+    }
+
+    GLuint program = glCreateProgram ();
+    GLint result = GL_FALSE;
+
+    glProgramBinary (program, header.format, binary.data (), header.length);
+    glGetProgramiv (program, GL_LINK_STATUS, &result);
+
+    // the driver might reject binaries even if it's the same version, compile them again
+    if (result == GL_FALSE)
+    {
+        glDeleteProgram (program);
+        return 0;
+    }
+
+    WallpaperEngine::FileSystem::touchCacheFile (path);
+
+    return program;
+}
+
+void CProgramCache::saveBinary (uint64_t hash, const std::string& vertex, const std::string& fragment, GLuint program)
+{
+    std::filesystem::path path = this->getBinaryPath (hash);
+
+    if (path.empty ())
+        return;
+
+    GLint length = 0;
+
+    glGetProgramiv (program, GL_PROGRAM_BINARY_LENGTH, &length);
+
+    if (length <= 0)
+        return;
+
+    ProgramBinaryHeader header {};
+    std::vector <char> binary (length);
+    GLenum format = 0;
+
+    glGetProgramBinary (program, length, nullptr, &format, binary.data ());
+
+    memcpy (header.magic, PROGRAM_BINARY_MAGIC, sizeof (PROGRAM_BINARY_MAGIC));
+    header.sourceHash = hash;
+    header.driverHash = this->m_driverHash;
+    header.sourceDigest = WallpaperEngine::FileSystem::contentDigest ({vertex, fragment});
+    header.format = format;
+    header.length = length;
+
+    // write to a temporary file first so other instances never see a partial file
+    static std::atomic <uint32_t> sequence = 0;
+    std::filesystem::path temporary = path;
+
+    temporary += "." + std::to_string (getpid ()) + "." + std::to_string (sequence ++) + ".tmp";
+
+    FILE* fp = fopen (temporary.c_str (), "wb");
+
+    if (fp == nullptr)
+        return;
+
+    bool success =
+        fwrite (&header, sizeof (header), 1, fp) == 1 &&
+        fwrite (binary.data (), binary.size (), 1, fp) == 1;
+
+    success = fclose (fp) == 0 && success;
+
+    std::error_code ec;
+
+    if (success)
+        std::filesystem::rename (temporary, path, ec);
+
+    if (!success || ec)
+        std::filesystem::remove (temporary, ec);
+}
@@ -0,0 +1,188 @@
+#pragma once
+
+#include <GL/glew.h>
+#include <cstdint>
+#include <filesystem>
+#include <map>
+#include <string>
+
+namespace WallpaperEngine::Render::Shaders
+{
+    /**
+     * Keeps the linked shader programs around so passes that end up with the exact same
+     * shader code (same shader, combos, constants, textures and patches) share the program
+     * instead of compiling and linking it again.
+     *
+     * Programs are keyed by the contents of the pre-processed sources, so anything that changes
+     * the generated code produces a different program. The hash only narrows down the search,
+     * the sources are always compared.
+     *
+     * When the driver supports it the linked binaries are also stored on disk, so the next run
+     * can skip compiling the shaders altogether
+     */
+    class CProgramCache
+    {
+    public:
+        /** Maximum amount of bytes the program binaries can take on disk */
+        static constexpr uintmax_t BinaryCacheBudget = 64 * 1024 * 1024;
+
+        CProgramCache ();
+        ~CProgramCache ();
+
+        /**
+         * Returns the program for the given sources, compiling and linking it only the first time
+         *
+         * @param name The name of the shader (used for errors and debug labels)
+         * @param vertex The pre-processed vertex shader
+         * @param fragment The pre-processed fragment shader
+         *
+         * @return The linked program
+         */
+        GLuint get (const std::string& name, const std::string& vertex, const std::string& fragment);
+        /**
+         * Returns the program for the given sources, new programs are sent to the driver
+         * without waiting for the result, so multiple programs can be compiled at the same time.
+         * The program must be resolved before it's used
+         *
+         * @param name The name of the shader (used for errors and debug labels)
+         * @param vertex The pre-processed vertex shader
+         * @param fragment The pre-processed fragment shader
+         *
+         * @return The program, might still be compiling
+         */
+        GLuint request (const std::string& name, const std::string& vertex, const std::string& fragment);
+        /**
+         * Waits for the given program to be linked and checks for errors, does nothing
+         * if the program was already resolved
+         *
+         * @param program The program returned by request
+         */
+        void resolve (GLuint program);
+        /**
+         * Looks up the location of an uniform in the program's active uniforms
+         *
+         * @param program The program to look in
+         * @param name The name of the uniform
+         *
+         * @return The location of the uniform, -1 if the program doesn't use it
+         */
+        GLint getUniformLocation (GLuint program, const std::string& name);
+        /**
+         * Lists the uniforms the program actually uses, the program is only queried the first time
+         *
+         * @param program The linked program
+         *
+         * @return The active uniforms by name with their location, arrays can be found by their name with and without [0]
+         */
+        const std::map <std::string, GLint>& getUniforms (GLuint program);
+        /**
+         * @return The amount of programs compiled so far
+         */
+        [[nodiscard]] size_t getProgramCount () const;
+        /**
+         * @return The amount of times a program was reused instead of compiled
+         */
+        [[nodiscard]] size_t getHitCount () const;
+
+    private:
+        /**
+         * A program and the sources it was built from
+         */
+        struct CachedProgram
+        {
+            std::string vertex;
+            std::string fragment;
+            GLuint program;
+        };
+
+        /**
+         * A program that was sent to the driver but not checked yet
+         */
+        struct PendingProgram
+        {
+            std::string name;
+            std::string vertex;
+            std::string fragment;
+            GLuint vertexShader;
+            GLuint fragmentShader;
+            uint64_t hash;
+        };
+
+        /**
+         * Starts compiling the given shader source
+         *
+         * @param source The shader's code
+         * @param type The type of shader
+         *
+         * @return The shader, might still be compiling
+         */
+        static GLuint compileShader (const std::string& source, GLenum type);
+        /**
+         * Waits for the shader to be compiled and checks for errors
+         *
+         * @param name The name of the shader (used for errors and debug labels)
+         * @param shader The shader to check
+         * @param source The shader's code (used for errors)
+         * @param type The type of shader
+         */
+        static void checkShader (const std::string& name, GLuint shader, const std::string& source, GLenum type);
+        /**
+         * Starts linking the given shaders into a program
+         *
+         * @return The program, might still be linking
+         */
+        static GLuint link (GLuint vertexShader, GLuint fragmentShader);
+        /**
+         * Waits for the program to be linked and checks for errors, the shaders are released afterwards
+         * if there's no errors
+         *
+         * @param pending The program to check
+         * @param program The program
+         */
+        static void checkProgram (const PendingProgram& pending, GLuint program);
+        /**
+         * @param hash The hash of the program's sources
+         *
+         * @return Where the binary of the program is stored, empty if there's no cache available
+         */
+        std::filesystem::path getBinaryPath (uint64_t hash);
+        /**
+         * Tries to load the program from its binary stored on disk
+         *
+         * @param hash The hash of the program's sources
+         * @param vertex The pre-processed vertex shader
+         * @param fragment The pre-processed fragment shader
+         *
+         * @return The program, 0 if there's no usable binary for it
+         */
+        GLuint loadBinary (uint64_t hash, const std::string& vertex, const std::string& fragment);
+        /**
+         * Stores the program's binary on disk so the next run doesn't have to compile it
+         *
+         * @param hash The hash of the program's sources
+         * @param vertex The pre-processed vertex shader
+         * @param fragment The pre-processed fragment shader
+         * @param program The linked program
+         */
+        void saveBinary (uint64_t hash, const std::string& vertex, const std::string& fragment, GLuint program);
+
+        /** Programs by the hash of their sources */
+        std::multimap <uint64_t, CachedProgram> m_programs;
+        /** Programs sent to the driver that were not checked yet */
+        std::map <GLuint, PendingProgram> m_pending;
+        /** Programs that failed to compile or link, with the error, their names stay allocated until the cache is destroyed */
+        std::map <GLuint, std::string> m_failed;
+        /** Active uniforms of every program */
+        std::map <GLuint, std::map <std::string, GLint>> m_uniforms;
+        /** Amount of times a program was reused */
+        size_t m_hits = 0;
+        /** Hash of the driver's vendor, renderer and version, binaries are only valid for the same driver */
+        uint64_t m_driverHash = 0;
+        /** Directory the binaries are stored in */
+        std::filesystem::path m_binaryDirectory;
+        /** Whether the binaries of the programs can be stored on disk */
+        bool m_binariesEnabled = false;
+        /** Whether the driver was already checked for binary support */
+        bool m_binariesChecked = false;
+    };
+}
@@ -9,11 +9,13 @@
 
 // shader compiler
 #include <WallpaperEngine/Render/Shaders/Compiler.h>
+#include <WallpaperEngine/Render/Shaders/CFrameGlobals.h>
+#include <WallpaperEngine/Render/Shaders/AtlasSampling.h>
 #include <WallpaperEngine/Core/Objects/Effects/Constants/CShaderConstantVector4.h>
 #include <WallpaperEngine/Core/Objects/Effects/Constants/CShaderConstantInteger.h>
 #include <WallpaperEngine/Core/Objects/Effects/Constants/CShaderConstantFloat.h>
-#include <regex>
 #include <filesystem>
+#include <set>
 
 #include "WallpaperEngine/Assets/CAssetLoadException.h"
 #include "WallpaperEngine/Render/Shaders/Variables/CShaderVariable.h"
@@ -50,21 +52,23 @@ namespace WallpaperEngine::Render::Shaders
         m_baseCombos ()
     {
         if (type == Type_Vertex)
-            this->m_content = this->m_container->readVertexShader (this->m_file);
+            this->m_source = this->m_container->readVertexShader (this->m_file);
         else if (type == Type_Pixel)
-            this->m_content = this->m_container->readFragmentShader (this->m_file);
+            this->m_source = this->m_container->readFragmentShader (this->m_file);
         else if (type == Type_Include)
-            this->m_content = this->m_container->readIncludeShader (this->m_file);
+            this->m_source = this->m_container->readIncludeShader (this->m_file);
+
+        this->m_content = this->m_source.view ();
 
         // clone the combos into the baseCombos to keep track of values that must be embedded no matter what
         for (const auto& cur : *this->m_combos)
             this->m_baseCombos.insert (std::make_pair (cur.first, cur.second));
     }
 
-    bool Compiler::peekString(std::string str, std::string::const_iterator& it)
+    bool Compiler::peekString (std::string_view str, std::string_view::const_iterator& it)
     {
-        std::string::const_iterator check = str.begin();
-        std::string::const_iterator cur = it;
+        std::string_view::const_iterator check = str.begin ();
+        std::string_view::const_iterator cur = it;
 
         while (cur != this->m_content.end () && check != str.end ())
         {
@@ -88,7 +92,7 @@ namespace WallpaperEngine::Render::Shaders
         return true;
     }
 
-    bool Compiler::expectSemicolon (std::string::const_iterator& it)
+    bool Compiler::expectSemicolon (std::string_view::const_iterator& it)
     {
         if (*it != ';')
         {
@@ -102,71 +106,215 @@ namespace WallpaperEngine::Render::Shaders
         return true;
     }
 
-    void Compiler::ignoreSpaces(std::string::const_iterator &it)
+    void Compiler::ignoreSpaces(std::string_view::const_iterator &it)
     {
         while (it != this->m_content.end() && (*it == ' ' || *it == '\t')) it ++;
     }
 
-    void Compiler::ignoreUpToNextLineFeed (std::string::const_iterator& it)
+    void Compiler::ignoreUpToNextLineFeed (std::string_view::const_iterator& it)
     {
         while (it != this->m_content.end() && *it != '\n') it ++;
     }
 
-    void Compiler::ignoreUpToBlockCommentEnd (std::string::const_iterator& it)
+    void Compiler::ignoreUpToBlockCommentEnd (std::string_view::const_iterator& it)
     {
         while (it != this->m_content.end() && !this->peekString ("*/", it)) it ++;
     }
 
-    std::string Compiler::extractType (std::string::const_iterator& it)
+    std::string Compiler::extractType (std::string_view::const_iterator& it)
     {
-        // first of all check for highp/mediump/lowp as these operators have to be ignored
-        this->peekString ("highp", it);
-        this->peekString ("mediump", it);
-        this->peekString ("lowp", it);
-        this->ignoreSpaces (it);
+        std::string_view::const_iterator cur = it;
+        std::string_view type = this->extractIdentifier (cur);
 
-        auto cur = sTypes.begin ();
-        auto end = sTypes.end ();
-
-        while (cur != end)
+        // highp/mediump/lowp have to be ignored
+        if (type == "highp" || type == "mediump" || type == "lowp")
         {
-            if (this->peekString (*cur + " ", it))
-                return *cur;
+            this->ignoreSpaces (cur);
+            type = this->extractIdentifier (cur);
+        }
 
-            cur ++;
+        // types are only taken into account when followed by a space
+        if (!isType (type) || cur == this->m_content.end () || *cur != ' ')
+        {
+            this->m_error = true;
+            this->m_errorInfo = "Expected type";
+            return "";
         }
 
-        this->m_error = true;
-        this->m_errorInfo = "Expected type";
-        return "";
+        it = ++cur;
+
+        return std::string (type);
     }
 
-    std::string Compiler::extractName (std::string::const_iterator& it)
+    std::string Compiler::extractName (std::string_view::const_iterator& it)
     {
-        std::string::const_iterator cur = it;
-        std::string::const_iterator begin = cur;
+        std::string_view name = this->extractIdentifier (it);
 
         // first character has to be a valid alphabetic characer
-        if (!this->isChar (cur) && *cur != '_')
+        if (name.empty ())
         {
             this->m_error = true;
             this->m_errorInfo = "Expected name doesn't start with a valid character";
             return "";
         }
 
-        cur ++;
+        return std::string (name);
+    }
+
+    std::string_view Compiler::extractIdentifier (std::string_view::const_iterator& it)
+    {
+        std::string_view::const_iterator cur = it;
+        std::string_view::const_iterator end = this->m_content.end ();
+
+        if (cur == end || (!this->isChar (cur) && *cur != '_'))
+            return {};
 
-        while (cur != this->m_content.end () && (this->isChar (cur) || *cur == '_' || this->isNumeric (cur))) cur ++;
+        while (cur != end && (this->isChar (cur) || *cur == '_' || this->isNumeric (cur))) cur ++;
+
+        std::string_view identifier (&*it, cur - it);
 
         it = cur;
 
-        return {begin, cur};
+        return identifier;
+    }
+
+    void Compiler::appendIdentifier (std::string_view identifier)
+    {
+        // gl_FragColor is gone in core profiles and sample is a reserved word in newer glsl versions
+        if (identifier == "gl_FragColor")
+            this->m_compiledContent += "out_FragColor";
+        else if (identifier == "sample")
+            this->m_compiledContent += "_sample";
+        else
+            this->m_compiledContent += identifier;
+    }
+
+    void Compiler::processIdentifier (std::string_view::const_iterator& it)
+    {
+        std::string_view::const_iterator start = it;
+        std::string_view::const_iterator end = this->m_content.end ();
+        std::string_view word = this->extractIdentifier (it);
+
+        if (word == "uniform" && it != end && *it == ' ')
+        {
+            it ++;
+            this->processUniform (it);
+        }
+        else if (word == "attribute" && it != end && *it == ' ')
+        {
+            it ++;
+            this->ignoreSpaces (it);
+            std::string type = this->extractType (it); if (this->m_error) return;
+            this->ignoreSpaces (it);
+            std::string name = this->extractName (it); if (this->m_error) return;
+            this->ignoreSpaces (it);
+            std::string array = this->extractArray (it, false); if (this->m_error) return;
+            this->ignoreSpaces (it);
+            this->expectSemicolon (it); if (this->m_error) return;
+
+            this->m_compiledContent += "attribute " + type + " ";
+            this->appendIdentifier (name);
+            this->m_compiledContent += array + ";";
+        }
+        else if (word == "highp" || word == "mediump" || word == "lowp")
+        {
+            // precision qualifiers are dropped
+            this->ignoreSpaces (it);
+        }
+        else if (isType (word) && it != end && *it == ' ')
+        {
+            this->ignoreSpaces (it);
+            std::string_view name = this->extractIdentifier (it);
+
+            // not a declaration (like a constructor followed by a space), keep it as is
+            if (name.empty ())
+            {
+                this->m_compiledContent.append (start, it);
+                return;
+            }
+
+            this->ignoreSpaces (it);
+
+            // check for functions, the includes have to go right before the first one
+            bool function = it != end && *it == '(';
+
+            if (function)
+            {
+                it ++;
+
+                if (!this->m_includesProcessed)
+                {
+                    this->m_compiledContent += "\n\n" + this->m_includesContent + "\n\n";
+                    this->m_includesProcessed = true;
+                }
+            }
+
+            this->m_compiledContent += word;
+            this->m_compiledContent += ' ';
+            this->appendIdentifier (name);
+
+            if (function)
+                this->m_compiledContent += '(';
+        }
+        else
+        {
+            this->appendIdentifier (word);
+        }
+    }
+
+    void Compiler::processUniform (std::string_view::const_iterator& it)
+    {
+        // uniforms might have extra information for their values
+        this->ignoreSpaces (it);
+        std::string type = this->extractType (it); if (this->m_error) return;
+        this->ignoreSpaces (it);
+        std::string name = this->extractName (it); if (this->m_error) return;
+        this->ignoreSpaces (it);
+        std::string array = this->extractArray (it, false); if (this->m_error) return;
+        this->ignoreSpaces (it);
+        this->expectSemicolon (it); if (this->m_error) return;
+        this->ignoreSpaces (it);
+
+        // values shared by every pass come from the frame globals block declared in the header
+        if (CFrameGlobals::isMember (type, name, array))
+        {
+            if (!this->m_compiledContent.empty () && this->m_compiledContent.back () != '\n')
+                this->m_compiledContent += '\n';
+
+            this->m_compiledContent += "#define " + name + " g_FrameGlobals." + name + "\n";
+            return;
+        }
+
+        this->m_compiledContent += "uniform " + type + " ";
+        this->appendIdentifier (name);
+        this->m_compiledContent += array;
+
+        // check if there is any actual extra information and parse it
+        if (this->peekString ("//", it))
+        {
+            this->ignoreSpaces (it);
+            std::string_view::const_iterator begin = it;
+            this->ignoreUpToNextLineFeed (it);
+
+            std::string configuration; configuration.append (begin, it);
+
+            // parse the parameter information
+            this->parseParameterConfiguration (type, name, configuration); if (this->m_error) return;
+            // the result depends on the pass this is compiled for, so it cannot be shared
+            this->m_cacheable = false;
+            this->m_compiledContent += "; // ";
+            this->m_compiledContent += configuration;
+        }
+        else
+        {
+            this->m_compiledContent += ";";
+        }
     }
 
-    std::string Compiler::extractArray(std::string::const_iterator &it, bool mustExists)
+    std::string Compiler::extractArray(std::string_view::const_iterator &it, bool mustExists)
     {
-        std::string::const_iterator cur = it;
-        std::string::const_iterator begin = cur;
+        std::string_view::const_iterator cur = it;
+        std::string_view::const_iterator begin = cur;
 
         if (*cur != '[')
         {
@@ -187,19 +335,26 @@ namespace WallpaperEngine::Render::Shaders
         return {begin, cur};
     }
 
-    bool Compiler::isChar (std::string::const_iterator& it)
+    bool Compiler::isChar (std::string_view::const_iterator& it)
     {
         return ((*it) >= 'A' && (*it) <= 'Z') || ((*it) >= 'a' && (*it) <= 'z');
     }
 
-    bool Compiler::isNumeric (std::string::const_iterator& it)
+    bool Compiler::isNumeric (std::string_view::const_iterator& it)
     {
         return (*it) >= '0' && (*it) <= '9';
     }
 
-    std::string Compiler::extractQuotedValue(std::string::const_iterator& it)
+    bool Compiler::isType (std::string_view word)
     {
-        std::string::const_iterator cur = it;
+        static const std::set <std::string_view> types (sTypes.begin (), sTypes.end ());
+
+        return types.find (word) != types.end ();
+    }
+
+    std::string Compiler::extractQuotedValue(std::string_view::const_iterator& it)
+    {
+        std::string_view::const_iterator cur = it;
 
         if (*cur != '"')
         {
@@ -229,27 +384,84 @@ namespace WallpaperEngine::Render::Shaders
 
     std::string Compiler::lookupShaderFile (std::string filename)
     {
+        // the pre-processed include doesn't depend on the combos, so the same file can be shared
+        // by every shader that includes it, the only thing to replay are the combos it defines
+        CFileView source = this->m_container->readIncludeShader (filename);
+        IncludeKey key (filename, FileSystem::contentHash (source.begin (), source.view ().size ()));
+
+        {
+            std::lock_guard <std::mutex> lock (sCacheMutex);
+
+            auto cur = sIncludes.find (key);
+
+            if (cur != sIncludes.end ())
+            {
+                for (const auto& configuration : cur->second->combos)
+                {
+                    this->parseComboConfiguration (configuration, 0);
+                    this->m_comboConfigurations.push_back (configuration);
+                }
+
+                return cur->second->code;
+            }
+        }
+
         // now compile the new shader
         // do not include the default header (as it's already included in the parent)
         Compiler loader (this->m_container, std::move (filename), Type_Include, this->m_combos, this->m_foundCombos, this->m_passTextures, this->m_constants, true);
 
         loader.precompile ();
 
-        return loader.getCompiled ();
+        // nested includes have to be replayed too
+        this->m_comboConfigurations.insert (
+            this->m_comboConfigurations.end (), loader.m_comboConfigurations.begin (), loader.m_comboConfigurations.end ()
+        );
+
+        if (!loader.m_cacheable)
+        {
+            this->m_cacheable = false;
+            return loader.getCompiled ();
+        }
+
+        auto entry = std::make_shared <IncludeEntry> ();
+
+        entry->code = loader.getCompiled ();
+        entry->combos = std::move (loader.m_comboConfigurations);
+
+        std::lock_guard <std::mutex> lock (sCacheMutex);
+
+        // another thread might have compiled the same include in the meantime, both are the same
+        return sIncludes.emplace (key, entry).first->second->code;
+    }
+
+    void Compiler::setAtlasedUnits (uint32_t units)
+    {
+        this->m_atlasedUnits = units;
     }
 
     std::string& Compiler::getCompiled ()
     {
-        return this->m_compiledContent;
+        // includes are pasted into other shaders as is
+        if (this->m_recursive)
+            return this->m_compiledContent;
+
+        // the header depends on the combos found by every stage of the pass, so it's generated when requested
+        // the atlased textures depend on what's bound to the pass, so the samples are rewritten here too
+        this->m_finalContent = this->generateHeader ();
+        this->m_finalContent += AtlasSampling::rewriteSamples (this->m_compiledContent, this->m_atlasedUnits);
+
+        sLog.debug("======================== COMPILED ", (this->m_type == Type_Vertex ? "VERTEX" : "FRAGMENT"), " SHADER ", this->m_file, " ========================");
+        sLog.debug(this->m_finalContent);
+
+        return this->m_finalContent;
     }
 
     void Compiler::precompile()
     {
-        // TODO: SEPARATE THIS IN TWO SO THE COMBOS ARE DETECTED FIRST AND WE DO NOT REQUIRE DOUBLE COMPILATION OF THE SHADER'S SOURCE
 #define BREAK_IF_ERROR if (this->m_error) { sLog.exception ("ERROR PRE-COMPILING SHADER.", this->m_errorInfo); }
         // parse the shader and find #includes and such things and translate them to the correct name
         // also remove any #version definition to prevent errors
-        std::string::const_iterator it = this->m_content.begin ();
+        std::string_view::const_iterator it = this->m_content.begin ();
 
         // reset error indicator
         this->m_error = false;
@@ -258,382 +470,272 @@ namespace WallpaperEngine::Render::Shaders
         this->m_includesContent = "";
         this->m_includesProcessed = false;
 
-        // search preprocessor macros and parse them
-        while (it != this->m_content.end () && !this->m_error)
+        std::string_view::const_iterator end = this->m_content.end ();
+        // characters that need no processing are copied in bulk from here
+        std::string_view::const_iterator pending = it;
+
+        // most of the shader ends up in the output as is
+        this->m_compiledContent.reserve (this->m_content.size () + this->m_content.size () / 8);
+
+        // tokenize the shader, only identifiers, comments and includes need processing
+        while (it != end && !this->m_error)
         {
-            if (*it == ' ' || *it == '\t' || *it == '\n' || *it == '\r' || *it == '\0' || *it == '{' || *it == '}' || *it == '[' || *it == ']' || *it == '.')
-            {
-                this->m_compiledContent += *it;
-                it ++;
-            }
-            else if (*it == '#')
+            std::string_view::const_iterator start = it;
+
+            if (*it == '#' && this->peekString ("#include ", it))
             {
-                if (this->peekString ("#include ", it))
+                this->m_compiledContent.append (pending, start);
+                // ignore whitespaces
+                this->ignoreSpaces (it); BREAK_IF_ERROR
+                // extract value between quotes
+                std::string filename = this->extractQuotedValue (it); BREAK_IF_ERROR
+
+                if (this->m_recursive)
                 {
-                    // ignore whitespaces
-                    this->ignoreSpaces (it); BREAK_IF_ERROR
-                    // extract value between quotes
-                    std::string filename = this->extractQuotedValue (it); BREAK_IF_ERROR
-
-                    if (this->m_recursive)
-                    {
-                        this->m_compiledContent += "// begin of include from file " + filename + "\r\n";
-                        this->m_compiledContent += this->lookupShaderFile (filename);
-                        this->m_compiledContent += "\r\n// end of included from file " + filename + "\r\n";
-                    }
-                    else
-                    {
-                        // load the content to the includes contents and continue with the next one
-                        // try to find the file first
-                        this->m_includesContent += "// begin of included from file " + filename + "\r\n";
-                        this->m_includesContent += this->lookupShaderFile (filename);
-                        this->m_includesContent += "\r\n// end of included from file " + filename + "\r\n";
-                    }
+                    this->m_compiledContent += "// begin of include from file " + filename + "\r\n";
+                    this->m_compiledContent += this->lookupShaderFile (filename);
+                    this->m_compiledContent += "\r\n// end of included from file " + filename + "\r\n";
                 }
                 else
                 {
-                    this->m_compiledContent += '#';
-                    it ++;
+                    // load the content to the includes contents and continue with the next one
+                    // try to find the file first
+                    this->m_includesContent += "// begin of included from file " + filename + "\r\n";
+                    this->m_includesContent += this->lookupShaderFile (filename);
+                    this->m_includesContent += "\r\n// end of included from file " + filename + "\r\n";
                 }
             }
-            else if (*it == 'u')
+            else if (*it == '/' && this->peekString ("//", it))
             {
-                // uniforms might have extra information for their values
-                if (this->peekString ("uniform ", it))
+                this->m_compiledContent.append (pending, start);
+                // is there a COMBO mark to take care of?
+                this->ignoreSpaces (it);
+
+                if (this->peekString ("[COMBO]", it))
                 {
+                    // parse combo json data to define the proper variables
                     this->ignoreSpaces (it);
-                    std::string type = this->extractType (it); BREAK_IF_ERROR
-                    this->ignoreSpaces (it);
-                    std::string name = this->extractName (it); BREAK_IF_ERROR
-                    this->ignoreSpaces (it);
-                    std::string array = this->extractArray (it, false); BREAK_IF_ERROR
-                    this->ignoreSpaces (it);
-                    this->expectSemicolon (it); BREAK_IF_ERROR
-                    this->ignoreSpaces (it);
+                    std::string_view::const_iterator begin = it;
+                    this->ignoreUpToNextLineFeed (it);
 
-                    // check if there is any actual extra information and parse it
-                    if (this->peekString ("//", it))
-                    {
-                        this->ignoreSpaces (it);
-                        std::string::const_iterator begin = it;
-                        this->ignoreUpToNextLineFeed (it);
-
-                        std::string configuration; configuration.append (begin, it);
-
-                        // parse the parameter information
-                        this->parseParameterConfiguration (type, name, configuration); BREAK_IF_ERROR
-                        this->m_compiledContent += "uniform ";
-                        this->m_compiledContent += type;
-                        this->m_compiledContent += " ";
-                        this->m_compiledContent += name;
-                        this->m_compiledContent += array;
-                        this->m_compiledContent += "; // ";
-                        this->m_compiledContent += configuration;
-                    }
-                    else
-                    {
-                        this->m_compiledContent += "uniform ";
-                        this->m_compiledContent += type;
-                        this->m_compiledContent += " ";
-                        this->m_compiledContent += name;
-                        this->m_compiledContent += array;
-                        this->m_compiledContent += ";";
-                    }
-                }
-                else
-                {
-                    // continue reading the original shader as this most likely is a variable name or something
-                    // that is not really interesting for the compiler
-                    this->m_compiledContent += *it;
-                    it ++;
+                    std::string configuration; configuration.append (begin, it);
+
+                    this->m_compiledContent += "// [COMBO] " + configuration;
+                    // add line feed just in case
+                    this->m_compiledContent += "\n";
+
+                    this->parseComboConfiguration (configuration, 0); BREAK_IF_ERROR;
+                    this->m_comboConfigurations.push_back (configuration);
                 }
-            }
-            else if (*it == 'a')
-            {
-                // find attribute definitions
-                if (this->peekString ("attribute ", it))
+                else if (this->peekString ("[COMBO_OFF]", it))
                 {
+                    // parse combo json data to define the proper variables
                     this->ignoreSpaces (it);
-                    std::string type = this->extractType (it); BREAK_IF_ERROR
-                    this->ignoreSpaces (it);
-                    std::string name = this->extractName (it); BREAK_IF_ERROR
-                    this->ignoreSpaces (it);
-                    std::string array = this->extractArray (it, false); BREAK_IF_ERROR
-                    this->ignoreSpaces (it);
-                    this->expectSemicolon (it); BREAK_IF_ERROR
+                    std::string_view::const_iterator begin = it;
+                    this->ignoreUpToNextLineFeed (it);
+
+                    std::string configuration; configuration.append (begin, it);
 
-                    this->m_compiledContent += "attribute " + type + " " + name + array + ";";
+                    this->m_compiledContent += "// [COMBO_OFF] " + configuration;
+                    // add line feed just in case
+                    this->m_compiledContent += "\n";
+
+                    this->parseComboConfiguration (configuration, 0); BREAK_IF_ERROR;
+                    this->m_comboConfigurations.push_back (configuration);
                 }
                 else
                 {
-                    // check for types first
-                    std::string type = this->extractType (it);
-
-                    // types not found, try names
-                    if (!this->m_error)
-                    {
-                        this->ignoreSpaces (it);
-                        this->m_compiledContent += type;
-                    }
-                    else
-                    {
-                        this->m_error = false;
-                        std::string name = this->extractName (it);
-
-                        if (!this->m_error)
-                        {
-                            // check if the name is a translated one or not
-                            this->m_compiledContent += name;
-                        }
-                        else
-                        {
-                            this->m_error = false;
-                            this->m_compiledContent += *it;
-                            it ++;
-                        }
-                    }
+                    // the comment can be ignored and put back as is
+                    this->ignoreUpToNextLineFeed (it);
+                    this->m_compiledContent.append (start, it);
                 }
             }
-            else if (*it == '/')
+            else if (*it == '/' && this->peekString ("/*", it))
             {
-                if (this->peekString ("//", it))
-                {
-                    std::string::const_iterator begin = it - 2;
-                    // is there a COMBO mark to take care of?
-                    this->ignoreSpaces (it);
-
-                    if (this->peekString ("[COMBO]", it))
-                    {
-                        // parse combo json data to define the proper variables
-                        this->ignoreSpaces (it);
-                        begin = it;
-                        this->ignoreUpToNextLineFeed (it);
-
-                        std::string configuration; configuration.append (begin, it);
-
-                        this->m_compiledContent += "// [COMBO] " + configuration;
-
-                        this->parseComboConfiguration (configuration, 0); BREAK_IF_ERROR;
-                    }
-                    else if (this->peekString ("[COMBO_OFF]", it))
-                    {
-                        // parse combo json data to define the proper variables
-                        this->ignoreSpaces (it);
-                        begin = it;
-                        this->ignoreUpToNextLineFeed (it);
-
-                        std::string configuration; configuration.append (begin, it);
-
-                        this->m_compiledContent += "// [COMBO_OFF] " + configuration;
-
-                        this->parseComboConfiguration (configuration, 0); BREAK_IF_ERROR;
-                    }
-                    else
-                    {
-                        // the comment can be ignored and put back as is
-                        this->ignoreUpToNextLineFeed(it);
-                        this->m_compiledContent.append (begin, it);
-                    }
-                }
-                else if (this->peekString ("/*", it))
-                {
-                    std::string::const_iterator begin = it - 2;
-                    this->ignoreUpToBlockCommentEnd (it);
-                    this->m_compiledContent.append (begin, it);
-                }
-                else
-                {
-                    this->m_compiledContent += *it;
-                    it ++;
-                }
+                this->m_compiledContent.append (pending, start);
+                this->ignoreUpToBlockCommentEnd (it);
+                this->m_compiledContent.append (start, it);
             }
-            else
+            else if (this->isChar (it) || *it == '_')
             {
-                // check for types first
-                std::string type = this->extractType (it);
-
-                // type found
-                if (!this->m_error)
-                {
-                    this->ignoreSpaces (it);
-                    // check for main, and take it into account, this also helps adding the includes
-                    std::string name = this->extractName (it);
-
-                    this->ignoreSpaces (it);
-
-                    if (this->peekString ("(", it))
-                    {
-                        if (!this->m_includesProcessed)
-                        {
-                            this->m_compiledContent += "\n\n" + this->m_includesContent + "\n\n";
-                            this->m_includesProcessed = true;
-                        }
-
-                        this->m_compiledContent += type + " " + name + "(";
-                    }
-                    else
-                    {
-                        this->m_compiledContent += type + " " + name;
-                    }
-                }
-                else
-                {
-                    this->m_error = false;
-                    std::string name = this->extractName (it);
-
-                    if (!this->m_error)
-                    {
-                        // check if the name is a translated one or not
-                        this->m_compiledContent += name;
-                    }
-                    else
-                    {
-                        this->m_error = false;
-                        this->m_compiledContent += *it++;
-                    }
-                }
+                this->m_compiledContent.append (pending, start);
+                this->processIdentifier (it); BREAK_IF_ERROR
             }
-        }
-
-        std::string finalCode;
-
-        if (!this->m_recursive)
-        {
-            // add the opengl compatibility at the top
-            finalCode =   "#version 330\n"
-                          "// ======================================================\n"
-                          "// Processed shader " + this->m_file + "\n"
-                          "// ======================================================\n"
-                          "precision highp float;\n"
-                          "#define mul(x, y) ((y) * (x))\n"
-                          "#define max(x, y) max (y, x)\n"
-                          "#define lerp mix\n"
-                          "#define frac fract\n"
-                          "#define CAST2(x) (vec2(x))\n"
-                          "#define CAST3(x) (vec3(x))\n"
-                          "#define CAST4(x) (vec4(x))\n"
-                          "#define CAST3X3(x) (mat3(x))\n"
-                          "#define saturate(x) (clamp(x, 0.0, 1.0))\n"
-                          "#define texSample2D texture\n"
-                          "#define texSample2DLod textureLod\n"
-                          "#define atan2 atan\n"
-                          "#define fmod(x, y) ((x)-(y)*trunc((x)/(y)))\n"
-                          "#define ddx dFdx\n"
-                          "#define ddy(x) dFdy(-(x))\n"
-                          "#define GLSL 1\n\n";
-
-            if (this->m_type == Type_Vertex)
+            else if (this->isNumeric (it))
             {
-                finalCode += "#define attribute in\n"
-                             "#define varying out\n";
+                // numbers never need processing, suffixes and exponents included
+                while (it != end && (this->isChar (it) || this->isNumeric (it) || *it == '_' || *it == '.')) it ++;
+                continue;
             }
             else
             {
-                finalCode += "out vec4 out_FragColor;\n"
-                             "#define varying in\n";
+                it ++;
+                continue;
             }
 
-            finalCode +=  "// ======================================================\n"
-                          "// Shader combo parameter definitions\n"
-                          "// ======================================================\n";
-
-            // add combo values
-            for (const auto& cur : *this->m_foundCombos)
-            {
-                // find the right value for the combo in the combos map
-                auto combo = this->m_combos->find (cur.first);
+            pending = it;
+        }
 
-                if (combo == this->m_combos->end ())
-                    continue;
+        this->m_compiledContent.append (pending, it);
 
-                finalCode += "#define " + cur.first + " " + std::to_string ((*combo).second) + "\n";
-            }
-            // add base combos that come from the pass change that MUST be added
-            for (const auto& cur : this->m_baseCombos)
-            {
-                auto alreadyFound = this->m_foundCombos->find (cur.first);
+        // the conditionals decide what has to be defined to 0 once the header is generated
+        if (!this->m_recursive)
+            this->scanConditionals ();
 
-                if (alreadyFound != this->m_foundCombos->end ())
-                    continue;
+        this->applyPatches ();
+#undef BREAK_IF_ERROR
+    }
 
-                finalCode += "#define " + cur.first + " " + std::to_string (cur.second) + "\n";
-            }
+    std::string Compiler::generateHeader () const
+    {
+        // add the opengl compatibility at the top
+        std::string finalCode = "#version 330\n"
+                                "// ======================================================\n"
+                                "// Processed shader " + this->m_file + "\n"
+                                "// ======================================================\n"
+                                "precision highp float;\n"
+                                "#define mul(x, y) ((y) * (x))\n"
+                                "#define max(x, y) max (y, x)\n"
+                                "#define lerp mix\n"
+                                "#define frac fract\n"
+                                "#define CAST2(x) (vec2(x))\n"
+                                "#define CAST3(x) (vec3(x))\n"
+                                "#define CAST4(x) (vec4(x))\n"
+                                "#define CAST3X3(x) (mat3(x))\n"
+                                "#define saturate(x) (clamp(x, 0.0, 1.0))\n"
+                                "#define texSample2D texture\n"
+                                "#define texSample2DLod textureLod\n"
+                                "#define atan2 atan\n"
+                                "#define fmod(x, y) ((x)-(y)*trunc((x)/(y)))\n"
+                                "#define ddx dFdx\n"
+                                "#define ddy(x) dFdy(-(x))\n"
+                                "#define GLSL 1\n\n";
+
+        // helpers to sample the region of the atlased textures
+        finalCode += AtlasSampling::getDeclarations (this->m_atlasedUnits);
+
+        // per-frame values shared by all the passes
+        finalCode += CFrameGlobals::getDeclaration ();
 
-            // define to 0 everything else found in the code
-            std::regex ifs ("#if ([A-Za-z0-9_]+)");
-            auto words_begin = std::sregex_iterator (this->m_compiledContent.begin (), this->m_compiledContent.end (), ifs);
-            auto words_end = std::sregex_iterator ();
-            std::map <std::string, bool> inserted;
+        if (this->m_type == Type_Vertex)
+        {
+            finalCode += "#define attribute in\n"
+                         "#define varying out\n";
+        }
+        else
+        {
+            finalCode += "out vec4 out_FragColor;\n"
+                         "#define varying in\n";
+        }
 
-            for (; words_begin != words_end; words_begin ++)
-            {
-                std::string define = (*words_begin).str ().substr (4);
+        finalCode +=  "// ======================================================\n"
+                      "// Shader combo parameter definitions\n"
+                      "// ======================================================\n";
 
-                if (
-                    this->m_foundCombos->find (define) != this->m_foundCombos->end () ||
-                        this->m_baseCombos.find (define) != this->m_baseCombos.end () ||
-                        inserted.find (define) != inserted.end ())
-                    continue;
+        // add combo values
+        for (const auto& cur : *this->m_foundCombos)
+        {
+            // find the right value for the combo in the combos map
+            auto combo = this->m_combos->find (cur.first);
 
-                finalCode += "#define " + define + " 0\n";
+            if (combo == this->m_combos->end ())
+                continue;
 
-                inserted.insert_or_assign (define, true);
-            }
+            finalCode += "#define " + cur.first + " " + std::to_string ((*combo).second) + "\n";
         }
+        // add base combos that come from the pass change that MUST be added
+        for (const auto& cur : this->m_baseCombos)
+        {
+            auto alreadyFound = this->m_foundCombos->find (cur.first);
 
-        // replace gl_FragColor with the equivalent
-        std::string from = "gl_FragColor";
-        std::string to = "out_FragColor";
+            if (alreadyFound != this->m_foundCombos->end ())
+                continue;
 
-        size_t start_pos = 0;
-        while((start_pos = this->m_compiledContent.find(from, start_pos)) != std::string::npos) {
-            this->m_compiledContent.replace(start_pos, from.length(), to);
-            start_pos += to.length(); // Handles case where 'to' is a substring of 'from'
+            finalCode += "#define " + cur.first + " " + std::to_string (cur.second) + "\n";
         }
 
-        // replace sample occurrences
-        from = "sample";
-        to = "_sample";
-
-        start_pos = 0;
-        while((start_pos = this->m_compiledContent.find(from, start_pos)) != std::string::npos) {
-            // ensure that after it comes something like a space or a ; or a tab
-            std::string after = this->m_compiledContent.substr (start_pos + from.length (), 1);
-
+        // define to 0 everything else found in the code
+        for (const auto& define : this->m_conditionals)
+        {
             if (
-                after != " " && after != ";" && after != "\t" &&
-                    after != "=" && after != "+" && after != "-" &&
-                    after != "/" && after != "*" && after != "." &&
-                    after != "," && after != ")")
-            {
-                start_pos += to.length(); // Handles case where 'to' is a substring of 'from'
+                this->m_foundCombos->find (define) != this->m_foundCombos->end () ||
+                    this->m_baseCombos.find (define) != this->m_baseCombos.end ())
                 continue;
-            }
 
-            this->m_compiledContent.replace(start_pos, from.length(), to);
-            start_pos += to.length(); // Handles case where 'to' is a substring of 'from'
+            finalCode += "#define " + define + " 0\n";
         }
 
-        try
+        return finalCode;
+    }
+
+    void Compiler::scanConditionals ()
+    {
+        std::set <std::string> inserted;
+        size_t position = 0;
+
+        this->m_conditionals.clear ();
+
+        // look for "#if NAME", anything more complex than that is left to the glsl pre-processor
+        while ((position = this->m_compiledContent.find ("#if ", position)) != std::string::npos)
         {
-            this->applyPatches ();
+            position += 4;
+            size_t end = position;
+
+            while (end < this->m_compiledContent.size () && (isalnum (this->m_compiledContent [end]) || this->m_compiledContent [end] == '_'))
+                end ++;
+
+            if (end == position)
+                continue;
+
+            std::string define = this->m_compiledContent.substr (position, end - position);
+
+            if (inserted.insert (define).second)
+                this->m_conditionals.push_back (define);
+
+            position = end;
         }
-        catch (CAssetLoadException&)
+    }
+
+    std::shared_ptr <const Compiler::PatchList> Compiler::lookupPatches (const std::filesystem::path& file)
+    {
+        uint32_t length = 0;
+        std::shared_ptr <const uint8_t[]> patchContents = this->m_container->tryReadFile (file, &length);
+
+        // nothing important, no patch was found
+        if (patchContents == nullptr)
+            return nullptr;
+
+        PatchKey key (file.string (), FileSystem::contentHash (patchContents.get (), length));
+
         {
-            // nothing important, no patch was found
+            std::lock_guard <std::mutex> lock (sCacheMutex);
+
+            auto cur = sPatches.find (key);
+
+            if (cur != sPatches.end ())
+                return cur->second;
         }
 
-        finalCode += this->m_compiledContent;
+        json data = json::parse (patchContents.get (), patchContents.get () + length);
+        auto patches = data.find ("patches");
+        auto list = std::make_shared <PatchList> ();
 
-        if (!this->m_recursive)
+        for (const auto& patch : *patches)
         {
-            sLog.debug("======================== COMPILED ", (this->m_type == Type_Vertex ? "VERTEX" : "FRAGMENT"), " SHADER ", this->m_file, " ========================");
-            sLog.debug(finalCode);
+            Patch entry;
+
+            for (const auto& match : *patch.find ("matches"))
+                entry.matches.push_back (match);
+
+            for (const auto& replacement : (*patch.find ("replacements")).items ())
+                entry.replacements.emplace_back (replacement.key (), replacement.value ());
+
+            list->push_back (std::move (entry));
         }
 
-        // store the final final code here
-        this->m_compiledContent = finalCode;
-#undef BREAK_IF_ERROR
+        std::lock_guard <std::mutex> lock (sCacheMutex);
+
+        return sPatches.emplace (key, list).first->second;
     }
 
     void Compiler::applyPatches ()
@@ -649,29 +751,21 @@ namespace WallpaperEngine::Render::Shaders
 
         file += ".json";
 
-        std::string tmp = file;
-        std::string patchContents = this->m_container->readFileAsString (file);
+        std::shared_ptr <const PatchList> patches = this->lookupPatches (file);
 
-        json data = json::parse (patchContents);
-        auto patches = data.find ("patches");
+        // nothing important, no patch was found
+        if (patches == nullptr)
+            return;
 
-        for (auto patch : *patches)
+        for (const auto& patch : *patches)
         {
-            auto matches = patch.find ("matches");
-
             // check for matches first, as these signal whether the patch can be applied or not
-            for (const auto& match : *matches)
+            for (const auto& match : patch.matches)
                 if (this->m_compiledContent.find (match) == std::string::npos)
                     continue;
 
-            auto replacements = patch.find ("replacements");
-
-            for (const auto& replacement : (*replacements).items ())
+            for (const auto& [from, to] : patch.replacements)
             {
-                // replace gl_FragColor with the equivalent
-                std::string from = replacement.key ();
-                std::string to = replacement.value ();
-
                 size_t start_pos = 0;
                 while((start_pos = this->m_compiledContent.find(from, start_pos)) != std::string::npos) {
                     this->m_compiledContent.replace(start_pos, from.length(), to);
@@ -688,9 +782,6 @@ namespace WallpaperEngine::Render::Shaders
         auto type = data.find ("type");
         auto defvalue = data.find ("default");
 
-        // add line feed just in case
-        this->m_compiledContent += "\n";
-
         // check the combos
         auto entry = this->m_combos->find ((*combo).get <std::string> ());
 
@@ -870,6 +961,10 @@ namespace WallpaperEngine::Render::Shaders
         return this->m_textures;
     }
 
+    std::mutex Compiler::sCacheMutex;
+    std::map <Compiler::IncludeKey, std::shared_ptr <const Compiler::IncludeEntry>> Compiler::sIncludes;
+    std::map <Compiler::PatchKey, std::shared_ptr <const Compiler::PatchList>> Compiler::sPatches;
+
     std::vector<std::string> Compiler::sTypes =
         {
             "vec4", "uvec4", "ivec4", "dvec4", "bvec4",
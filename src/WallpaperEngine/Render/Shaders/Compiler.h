@@ -1,8 +1,11 @@
 #pragma once
 
 #include <iostream>
+#include <string_view>
 #include <vector>
 #include <map>
+#include <memory>
+#include <mutex>
 
 #include "WallpaperEngine/Core/Core.h"
 #include "WallpaperEngine/Assets/CContainer.h"
@@ -65,10 +68,20 @@ namespace WallpaperEngine::Render::Shaders
          * This step is kinda big, replaces variables names on sVariableReplacement,
          * ensures #include directives are correctly handled
          * and takes care of attribute comments for the wallpaper engine specifics
+         *
+         * The combo definitions depend on every stage of the pass, so they're only
+         * added when the compiled code is requested
          */
         void precompile ();
         /**
-         * @return The compiled shader's text (if available)
+         * Makes the texSample2D calls on the given g_TextureN samplers sample the texture's region in the atlas,
+         * can be changed after precompile
+         *
+         * @param units Bit mask of the texture units that are bound to an atlased texture
+         */
+        void setAtlasedUnits (uint32_t units);
+        /**
+         * @return The compiled shader's text (if available) with the header for the current combos
          */
         std::string& getCompiled ();
 
@@ -103,7 +116,7 @@ namespace WallpaperEngine::Render::Shaders
          *
          * @return
          */
-        bool peekString (std::string str, std::string::const_iterator& it);
+        bool peekString (std::string_view str, std::string_view::const_iterator& it);
         /**
          * Checks for a semicolon as current character, advancing the iterator
          * after finding it, otherwise returns an error
@@ -112,26 +125,26 @@ namespace WallpaperEngine::Render::Shaders
          *
          * @return
          */
-        bool expectSemicolon (std::string::const_iterator& it);
+        bool expectSemicolon (std::string_view::const_iterator& it);
         /**
          * Ignores contiguous space characters in the string advancing the iterator
          * until the first non-space character
          *
          * @param it The iterator to increase
          */
-        void ignoreSpaces (std::string::const_iterator& it);
+        void ignoreSpaces (std::string_view::const_iterator& it);
         /**
          * Ignores all characters until next line-fee (\n) advancing the interator
          *
          * @param it The iterator to increase
          */
-        void ignoreUpToNextLineFeed (std::string::const_iterator& it);
+        void ignoreUpToNextLineFeed (std::string_view::const_iterator& it);
         /**
          * Ignores all characters until a block comment end is found, advancing the iterator
          *
          * @param it The iterator to increase
          */
-        void ignoreUpToBlockCommentEnd (std::string::const_iterator& it);
+        void ignoreUpToBlockCommentEnd (std::string_view::const_iterator& it);
         /**
          * Parses the current position as a variable type, extracts it and compares it
          * to the registered types in the pre-processor, returning it's name if valid
@@ -141,7 +154,7 @@ namespace WallpaperEngine::Render::Shaders
          *
          * @return The type name
          */
-        std::string extractType (std::string::const_iterator& it);
+        std::string extractType (std::string_view::const_iterator& it);
         /**
          * Parses the current position as a variable name, extractig it's name and
          * increasing the iterator as the name is extracted
@@ -150,7 +163,37 @@ namespace WallpaperEngine::Render::Shaders
          *
          * @return The variable name
          */
-        std::string extractName (std::string::const_iterator& it);
+        std::string extractName (std::string_view::const_iterator& it);
+        /**
+         * Extracts the identifier (name, type or keyword) at the current position
+         * increasing the iterator as it's extracted
+         *
+         * @param it The position to start extracting the identifier from
+         *
+         * @return The identifier, empty if there isn't any at the current position
+         */
+        std::string_view extractIdentifier (std::string_view::const_iterator& it);
+        /**
+         * Handles the identifier at the current position, taking care of declarations
+         * (uniforms, attributes and functions) and writing it to the compiled content
+         *
+         * @param it The position the identifier starts at
+         */
+        void processIdentifier (std::string_view::const_iterator& it);
+        /**
+         * Parses an uniform declaration right after the uniform keyword
+         * alongside its configuration comment (if any)
+         *
+         * @param it The position to start parsing from
+         */
+        void processUniform (std::string_view::const_iterator& it);
+        /**
+         * Writes the given identifier to the compiled content, renaming
+         * the ones that are not valid in the target glsl version
+         *
+         * @param identifier The identifier to write
+         */
+        void appendIdentifier (std::string_view identifier);
         /**
          * Parses the current position as an array indicator
          *
@@ -158,7 +201,7 @@ namespace WallpaperEngine::Render::Shaders
          * @param mustExists    Whether the array indicator must exists or not
          * @return
          */
-        std::string extractArray(std::string::const_iterator &it, bool mustExists = false);
+        std::string extractArray(std::string_view::const_iterator &it, bool mustExists = false);
         /**
          * Parses the current position as a quoted value, extracting it's value
          * and increasing the iterator at the same time
@@ -167,7 +210,7 @@ namespace WallpaperEngine::Render::Shaders
          *
          * @return The value
          */
-        std::string extractQuotedValue (std::string::const_iterator& it);
+        std::string extractQuotedValue (std::string_view::const_iterator& it);
         /**
          * Tries to find the given shader file and compile it
          *
@@ -180,11 +223,15 @@ namespace WallpaperEngine::Render::Shaders
         /**
          * @return Whether the character in the current position is a character or not
          */
-        static bool isChar (std::string::const_iterator& it);
+        static bool isChar (std::string_view::const_iterator& it);
         /**
          * @return Whether the character in the current position is a number or not
          */
-        static bool isNumeric (std::string::const_iterator& it);
+        static bool isNumeric (std::string_view::const_iterator& it);
+        /**
+         * @return Whether the given identifier is one of the types the pre-processor understands
+         */
+        static bool isType (std::string_view word);
         /**
          * Parses a COMBO value to add the proper define to the code
          *
@@ -199,25 +246,88 @@ namespace WallpaperEngine::Render::Shaders
          * @param content The parameter configuration
          */
         void parseParameterConfiguration (const std::string& type, const std::string& name, const std::string& content);
+        /**
+         * @return The definitions and compatibility code that go before the shader's code
+         */
+        [[nodiscard]] std::string generateHeader () const;
+        /**
+         * Looks for the "#if NAME" conditionals in the pre-processed code,
+         * the ones that are not combos are defined to 0 in the header
+         */
+        void scanConditionals ();
         /**
          * Applies any available patches for this shader
          */
         void applyPatches ();
 
+        /**
+         * A pre-processed include, shared by every shader that includes the same file
+         */
+        struct IncludeEntry
+        {
+            /** The pre-processed code */
+            std::string code;
+            /** Configuration of the combos defined in the include (and its includes), in order */
+            std::vector <std::string> combos;
+        };
+
+        /**
+         * A patch rule, the replacements are applied to the pre-processed code
+         */
+        struct Patch
+        {
+            std::vector <std::string> matches;
+            std::vector <std::pair <std::string, std::string>> replacements;
+        };
+
+        using PatchList = std::vector <Patch>;
+        /** Filename and content hash */
+        using IncludeKey = std::pair <std::string, uint64_t>;
+        /** Filename and content hash */
+        using PatchKey = std::pair <std::string, uint64_t>;
+
+        /**
+         * Reads and parses the given patch file, parsed files are shared by the whole process
+         *
+         * @param file The patch file
+         *
+         * @return The patches in the file, nullptr if there is no such file
+         */
+        std::shared_ptr <const PatchList> lookupPatches (const std::filesystem::path& file);
+
+        /** Protects the include and patch caches, shaders can be compiled from multiple threads */
+        static std::mutex sCacheMutex;
+        /** Includes already pre-processed */
+        static std::map <IncludeKey, std::shared_ptr <const IncludeEntry>> sIncludes;
+        /** Patch files already parsed */
+        static std::map <PatchKey, std::shared_ptr <const PatchList>> sPatches;
+
         /**
          * The shader file this instance is loading
          */
         std::string m_file;
+        /**
+         * The original file, kept around so m_content stays valid
+         */
+        CFileView m_source;
         /**
          * The original file content
          */
-        std::string m_content;
+        std::string_view m_content;
         /** The content of all the included files */
         std::string m_includesContent;
         /**
-         * The final, compiled content ready to be used by OpenGL
+         * The pre-processed content, without the header
          */
         std::string m_compiledContent;
+        /**
+         * The pre-processed content with the header, what OpenGL gets
+         */
+        std::string m_finalContent;
+        /**
+         * The names used in "#if NAME" conditionals, in order
+         */
+        std::vector <std::string> m_conditionals;
         /**
          * Whether there was any kind of error in the compilation or not
          */
@@ -270,5 +380,17 @@ namespace WallpaperEngine::Render::Shaders
          */
         std::map<int, std::string> m_textures;
         bool m_includesProcessed = false;
+        /**
+         * Bit mask of the texture units that are bound to an atlased texture
+         */
+        uint32_t m_atlasedUnits = 0;
+        /**
+         * Configuration of the combos found while pre-processing, so includes can be replayed from the cache
+         */
+        std::vector <std::string> m_comboConfigurations;
+        /**
+         * Whether the pre-processed code only depends on the file, includes with parameters depend on the pass
+         */
+        bool m_cacheable = true;
     };
 }
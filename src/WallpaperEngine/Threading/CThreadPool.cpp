@@ -0,0 +1,100 @@
+#include "CThreadPool.h"
+
+using namespace WallpaperEngine::Threading;
+
+/** The pool the current thread works for, nullptr if it's not a worker */
+static thread_local const CThreadPool* sCurrentPool = nullptr;
+
+CThreadPool::CThreadPool (size_t threads) :
+    m_stop (false)
+{
+    if (threads == 0)
+        threads = std::max (1U, std::thread::hardware_concurrency ());
+
+    for (size_t i = 0; i < threads; i ++)
+        this->m_threads.emplace_back (&CThreadPool::work, this);
+}
+
+CThreadPool::~CThreadPool ()
+{
+    {
+        std::lock_guard <std::mutex> lock (this->m_mutex);
+        this->m_stop = true;
+    }
+
+    this->m_condition.notify_all ();
+
+    for (auto& cur : this->m_threads)
+        cur.join ();
+}
+
+CThreadPool& CThreadPool::get ()
+{
+    static CThreadPool pool;
+
+    return pool;
+}
+
+size_t CThreadPool::getThreadCount () const
+{
+    return this->m_threads.size ();
+}
+
+bool CThreadPool::isWorker () const
+{
+    return sCurrentPool == this;
+}
+
+void CThreadPool::enqueue (std::function <void ()> task)
+{
+    {
+        std::lock_guard <std::mutex> lock (this->m_mutex);
+        this->m_tasks.push_back (std::move (task));
+    }
+
+    this->m_condition.notify_one ();
+}
+
+bool CThreadPool::runPendingTask ()
+{
+    std::function <void ()> task;
+
+    {
+        std::lock_guard <std::mutex> lock (this->m_mutex);
+
+        if (this->m_tasks.empty ())
+            return false;
+
+        task = std::move (this->m_tasks.front ());
+        this->m_tasks.pop_front ();
+    }
+
+    task ();
+
+    return true;
+}
+
+void CThreadPool::work ()
+{
+    sCurrentPool = this;
+
+    while (true)
+    {
+        std::function <void ()> task;
+
+        {
+            std::unique_lock <std::mutex> lock (this->m_mutex);
+
+            this->m_condition.wait (lock, [this] { return this->m_stop || !this->m_tasks.empty (); });
+
+            // finish whatever is queued before shutting down
+            if (this->m_stop && this->m_tasks.empty ())
+                return;
+
+            task = std::move (this->m_tasks.front ());
+            this->m_tasks.pop_front ();
+        }
+
+        task ();
+    }
+}
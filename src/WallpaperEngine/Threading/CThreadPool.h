@@ -0,0 +1,112 @@
+#pragma once
+
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace WallpaperEngine::Threading
+{
+    /**
+     * Simple worker pool used to move CPU and I/O heavy work (file reads, decoding...) off the main thread
+     *
+     * Tasks must not touch OpenGL, the context is only available on the render thread
+     */
+    class CThreadPool
+    {
+    public:
+        /**
+         * @param threads The amount of worker threads to start, 0 to use one per CPU core
+         */
+        explicit CThreadPool (size_t threads = 0);
+        ~CThreadPool ();
+
+        /**
+         * @return The process-wide thread pool
+         */
+        static CThreadPool& get ();
+
+        /**
+         * Queues a new task in the pool
+         *
+         * @param task The task to run
+         *
+         * @return Future to get the result of the task from
+         */
+        template <typename F>
+        std::future <std::invoke_result_t <F>> submit (F task)
+        {
+            auto packaged = std::make_shared <std::packaged_task <std::invoke_result_t <F> ()>> (std::move (task));
+            auto result = packaged->get_future ();
+
+            this->enqueue ([packaged] () { (*packaged) (); });
+
+            return result;
+        }
+
+        /**
+         * Waits for the given task to finish. Workers run queued tasks in the meantime so tasks that
+         * wait for other tasks in the pool cannot deadlock it, other threads (like the render thread)
+         * just block so they don't pick up unrelated work
+         *
+         * @param future The task to wait for
+         *
+         * @return The result of the task
+         */
+        template <typename T>
+        T wait (std::future <T>& future)
+        {
+            if (this->isWorker ())
+            {
+                // nothing else to do once the queue is empty, the task is running somewhere else
+                while (future.wait_for (std::chrono::seconds (0)) != std::future_status::ready)
+                    if (!this->runPendingTask ())
+                        break;
+            }
+
+            return future.get ();
+        }
+
+        /**
+         * @return The amount of worker threads in the pool
+         */
+        [[nodiscard]] size_t getThreadCount () const;
+
+    private:
+        /**
+         * @return If the calling thread is one of this pool's workers
+         */
+        [[nodiscard]] bool isWorker () const;
+        /**
+         * Adds the task to the queue and wakes up a worker
+         *
+         * @param task
+         */
+        void enqueue (std::function <void ()> task);
+        /**
+         * Runs the next queued task on the calling thread
+         *
+         * @return If there was any task to run
+         */
+        bool runPendingTask ();
+        /**
+         * Main loop of the worker threads
+         */
+        void work ();
+
+        /** The worker threads */
+        std::vector <std::thread> m_threads;
+        /** Tasks waiting for a worker */
+        std::deque <std::function <void ()>> m_tasks;
+        /** Protects the task queue */
+        std::mutex m_mutex;
+        /** Used to wake up the workers when there's new tasks */
+        std::condition_variable m_condition;
+        /** Whether the pool is shutting down */
+        bool m_stop;
+    };
+}
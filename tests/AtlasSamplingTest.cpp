@@ -0,0 +1,80 @@
+#include <fstream>
+#include <iostream>
+#include <string>
+
+#include "WallpaperEngine/Render/Shaders/AtlasSampling.h"
+
+using namespace WallpaperEngine::Render::Shaders;
+
+static int failures = 0;
+
+static void check (bool condition, const std::string& description)
+{
+    if (condition)
+        return;
+
+    std::cerr << "FAILED: " << description << std::endl;
+    failures ++;
+}
+
+static bool contains (const std::string& code, const std::string& text)
+{
+    return code.find (text) != std::string::npos;
+}
+
+/**
+ * Fragment shader that uses its samplers in ways a struct can't be used in,
+ * only g_Texture0 is atlased
+ */
+static const char* SHADER =
+    "uniform sampler2D g_Texture0;\n"
+    "uniform sampler2D g_Texture1;\n"
+    "in vec2 v_TexCoord;\n"
+    "out vec4 out_FragColor;\n"
+    "vec4 blur (sampler2D s, vec2 uv) { return texSample2D (s, uv); }\n"
+    "void main () {\n"
+    "    vec2 size = vec2 (textureSize(g_Texture0, 0));\n"
+    "    vec4 texel = texelFetch (g_Texture0, ivec2 (v_TexCoord * size), 0);\n"
+    "    vec4 albedo = texSample2D(g_Texture0, v_TexCoord);\n"
+    "    vec4 lod = texSample2DLod ( g_Texture0 , v_TexCoord, 2.0);\n"
+    "    vec4 mask = texSample2D(g_Texture1, v_TexCoord);\n"
+    "    out_FragColor = albedo * mask + texel + lod + blur (g_Texture0, v_TexCoord);\n"
+    "}\n";
+
+int main (int argc, char* argv [])
+{
+    std::string code = AtlasSampling::rewriteSamples (SHADER, 1);
+    std::string declarations = AtlasSampling::getDeclarations (1);
+
+    check (contains (code, "uniform sampler2D g_Texture0;"), "the atlased sampler keeps its declaration");
+    check (contains (code, "textureSize(g_Texture0, 0)"), "textureSize on the atlased sampler is kept");
+    check (contains (code, "texelFetch (g_Texture0, "), "texelFetch on the atlased sampler is kept");
+    check (contains (code, "blur (g_Texture0, v_TexCoord)"), "the atlased sampler can be passed to functions");
+    check (contains (code, "texSample2D (s, uv)"), "samples on function parameters are not rewritten");
+    check (
+        contains (code, "atlasSample2D (g_Texture0, g_Texture0AtlasRect, g_Texture0AtlasBounds, v_TexCoord)"),
+        "samples on the atlased sampler are rewritten"
+    );
+    check (
+        contains (code, "atlasSample2DLod (g_Texture0, g_Texture0AtlasRect, g_Texture0AtlasBounds , v_TexCoord, 2.0)"),
+        "lod samples on the atlased sampler are rewritten"
+    );
+    check (contains (code, "texSample2D(g_Texture1, v_TexCoord)"), "samples on other samplers are not rewritten");
+    check (contains (declarations, "uniform vec4 g_Texture0AtlasRect;"), "the region of the atlased sampler is declared");
+    check (!contains (declarations, "g_Texture1"), "the other samplers have no region");
+    check (AtlasSampling::rewriteSamples (SHADER, 0) == SHADER, "nothing is rewritten without atlased samplers");
+    check (AtlasSampling::getDeclarations (0).empty (), "nothing is declared without atlased samplers");
+
+    // write the full shader so it can be compiled
+    if (argc > 1)
+    {
+        std::ofstream output (argv [1]);
+
+        output << "#version 330\n"
+                  "#define texSample2D texture\n"
+                  "#define texSample2DLod textureLod\n"
+               << declarations << code;
+    }
+
+    return failures == 0 ? 0 : 1;
+}
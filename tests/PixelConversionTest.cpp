@@ -0,0 +1,150 @@
+#include <chrono>
+#include <cstring>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "WallpaperEngine/Assets/PixelConversion.h"
+
+using namespace WallpaperEngine::Assets;
+
+static int failures = 0;
+
+static void check (bool condition, const std::string& description)
+{
+    if (condition)
+        return;
+
+    std::cerr << "FAILED: " << description << std::endl;
+    failures ++;
+}
+
+using ExpandFunction = void (*) (const uint8_t*, uint8_t*, uint32_t);
+
+/**
+ * Compares the given version of expandRow against the plain C++ one on rows of different lengths,
+ * the source buffers are exactly as big as the row so reading past them shows up with sanitizers
+ */
+static void checkExpand (ExpandFunction expand, const std::string& name, std::mt19937& random)
+{
+    std::vector <uint32_t> lengths;
+
+    for (uint32_t i = 0; i <= 70; i ++)
+        lengths.push_back (i);
+
+    lengths.push_back (1920);
+    lengths.push_back (3840);
+
+    for (uint32_t pixels : lengths)
+    {
+        std::vector <uint8_t> source (pixels * 3);
+        std::vector <uint8_t> expected (pixels * 4);
+        std::vector <uint8_t> result (pixels * 4);
+
+        for (auto& cur : source)
+            cur = static_cast <uint8_t> (random ());
+
+        PixelConversion::expandRowScalar (source.data (), expected.data (), pixels);
+        expand (source.data (), result.data (), pixels);
+
+        check (result == expected, name + " expands a row of " + std::to_string (pixels) + " pixels");
+    }
+}
+
+static FIBITMAP* createBitmap (uint32_t width, uint32_t height, uint32_t bpp, std::mt19937& random)
+{
+    FIBITMAP* bitmap = FreeImage_Allocate (width, height, bpp);
+    uint8_t* bits = FreeImage_GetBits (bitmap);
+    size_t size = static_cast <size_t> (FreeImage_GetPitch (bitmap)) * height;
+
+    for (size_t i = 0; i < size; i ++)
+        bits [i] = static_cast <uint8_t> (random ());
+
+    return bitmap;
+}
+
+static bool samePixels (FIBITMAP* first, FIBITMAP* second)
+{
+    uint32_t width = FreeImage_GetWidth (first);
+    uint32_t height = FreeImage_GetHeight (first);
+
+    if (FreeImage_GetBPP (first) != 32 || FreeImage_GetBPP (second) != 32 ||
+        FreeImage_GetWidth (second) != width || FreeImage_GetHeight (second) != height)
+        return false;
+
+    for (uint32_t y = 0; y < height; y ++)
+        if (memcmp (FreeImage_GetScanLine (first, y), FreeImage_GetScanLine (second, y), width * 4) != 0)
+            return false;
+
+    return true;
+}
+
+/**
+ * Checks convertFlipped gives the same pixels FreeImage_FlipVertical + FreeImage_ConvertTo32Bits did
+ * and reports how long each of them takes
+ */
+static void checkConvert (uint32_t width, uint32_t height, uint32_t bpp, int iterations, std::mt19937& random)
+{
+    std::string name = std::to_string (width) + "x" + std::to_string (height) + " " + std::to_string (bpp) + " bits";
+    FIBITMAP* bitmap = createBitmap (width, height, bpp, random);
+    double converted = 0, reference = 0;
+    bool same = true;
+
+    for (int i = 0; i < iterations; i ++)
+    {
+        auto start = std::chrono::steady_clock::now ();
+        FIBITMAP* result = PixelConversion::convertFlipped (bitmap);
+        auto middle = std::chrono::steady_clock::now ();
+        // this is what the textures did before, the flip is done in place so it's undone by the next iteration
+        FreeImage_FlipVertical (bitmap);
+        FIBITMAP* expected = FreeImage_ConvertTo32Bits (bitmap);
+        auto end = std::chrono::steady_clock::now ();
+
+        converted += std::chrono::duration <double, std::milli> (middle - start).count ();
+        reference += std::chrono::duration <double, std::milli> (end - middle).count ();
+
+        same = same && result != nullptr && samePixels (result, expected);
+
+        // bring the bitmap back to its original orientation
+        FreeImage_FlipVertical (bitmap);
+        FreeImage_Unload (result);
+        FreeImage_Unload (expected);
+    }
+
+    FreeImage_Unload (bitmap);
+
+    check (same, "convertFlipped matches FreeImage on " + name);
+
+    std::cout << name << ": convertFlipped " << converted / iterations << " ms, "
+              << "FreeImage_FlipVertical + FreeImage_ConvertTo32Bits " << reference / iterations << " ms" << std::endl;
+}
+
+int main (int argc, char* argv [])
+{
+    // fixed seed so failures can be reproduced
+    std::mt19937 random (1234);
+
+    checkExpand (PixelConversion::expandRow, "expandRow", random);
+
+#if PIXEL_CONVERSION_X86
+    if (__builtin_cpu_supports ("ssse3"))
+        checkExpand (PixelConversion::expandRowSSSE3, "expandRowSSSE3", random);
+    else
+        std::cout << "SSSE3 not supported, skipping" << std::endl;
+
+    if (__builtin_cpu_supports ("avx2"))
+        checkExpand (PixelConversion::expandRowAVX2, "expandRowAVX2", random);
+    else
+        std::cout << "AVX2 not supported, skipping" << std::endl;
+#endif /* PIXEL_CONVERSION_X86 */
+
+    // odd sizes so the rows are padded
+    checkConvert (37, 13, 24, 1, random);
+    checkConvert (37, 13, 32, 1, random);
+    // the size of the wallpapers that benefit the most
+    checkConvert (3840, 2160, 24, 5, random);
+    checkConvert (3840, 2160, 32, 5, random);
+
+    return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,88 @@
+#include <algorithm>
+#include <cstdio>
+#include <iostream>
+#include <string>
+
+#include "WallpaperEngine/FileSystem/CSha256.h"
+
+using namespace WallpaperEngine::FileSystem;
+
+static int failures = 0;
+
+static void check (bool condition, const std::string& description)
+{
+    if (condition)
+        return;
+
+    std::cerr << "FAILED: " << description << std::endl;
+    failures ++;
+}
+
+static std::string toHex (const Digest& digest)
+{
+    std::string result;
+    char buffer [3];
+
+    for (uint8_t cur : digest)
+    {
+        snprintf (buffer, sizeof (buffer), "%02x", cur);
+        result += buffer;
+    }
+
+    return result;
+}
+
+/**
+ * Hashes the input in chunks of the given size so the block handling is exercised too
+ */
+static std::string hash (const std::string& input, size_t chunk)
+{
+    CSha256 sha;
+
+    for (size_t offset = 0; offset < input.size (); offset += chunk)
+        sha.update (input.data () + offset, std::min (chunk, input.size () - offset));
+
+    return toHex (sha.finish ());
+}
+
+static void checkVector (const std::string& input, const std::string& expected, const std::string& description)
+{
+    check (hash (input, input.size () + 1) == expected, description);
+    check (hash (input, 1) == expected, description + " (byte by byte)");
+    check (hash (input, 63) == expected, description + " (in 63 byte chunks)");
+}
+
+int main (int argc, char* argv [])
+{
+    // FIPS 180-4 examples
+    checkVector ("", "e3b0c44298fc1c149afbf4c8996fb92427ae41e4649b934ca495991b7852b855", "empty input");
+    checkVector ("abc", "ba7816bf8f01cfea414140de5dae2223b00361a396177a9cb410ff61f20015ad", "\"abc\"");
+    checkVector (
+        "abcdbcdecdefdefgefghfghighijhijkijkljklmklmnlmnomnopnopq",
+        "248d6a61d20638b8e5c026930c3e6039a33ce45964ff2167f6ecedd419db06c1",
+        "two block message"
+    );
+    checkVector (
+        std::string (1000000, 'a'),
+        "cdc76e5c9914fb9281a1c7e284d73e67f1809a48a497200e046d39ccc7112cd0",
+        "one million 'a'"
+    );
+    // the length field fits in the last block or forces an extra one
+    checkVector (
+        std::string (55, 'x'),
+        "d5e285683cd4efc02d021a5c62014694958901005d6f71e89e0989fac77e4072",
+        "55 bytes"
+    );
+    checkVector (
+        std::string (56, 'x'),
+        "04c26261370ee7541549d16dee320c723e3fd14671e66a099afe0a377c16888e",
+        "56 bytes"
+    );
+    checkVector (
+        std::string (64, 'x'),
+        "7ce100971f64e7001e8fe5a51973ecdfe1ced42befe7ee8d5fd6219506b5393c",
+        "64 bytes"
+    );
+
+    return failures == 0 ? 0 : 1;
+}
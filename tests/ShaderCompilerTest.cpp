@@ -0,0 +1,171 @@
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+
+#include "WallpaperEngine/Assets/CDirectory.h"
+#include "WallpaperEngine/Render/Shaders/Compiler.h"
+
+using namespace WallpaperEngine::Assets;
+using namespace WallpaperEngine::Render::Shaders;
+
+static int failures = 0;
+
+static void check (bool condition, const std::string& description)
+{
+    if (condition)
+        return;
+
+    std::cerr << "FAILED: " << description << std::endl;
+    failures ++;
+}
+
+static std::string readFile (const std::filesystem::path& path)
+{
+    std::ifstream input (path, std::ios::binary);
+    std::stringstream buffer;
+
+    buffer << input.rdbuf ();
+
+    return buffer.str ();
+}
+
+/**
+ * The pre-processed code of both stages of a pass
+ */
+struct CompiledPass
+{
+    std::string vertex;
+    std::string fragment;
+};
+
+/**
+ * Pre-processes both stages of a pass the same way CPass does
+ *
+ * @param container Where the shaders are read from
+ * @param shader The shader of the pass
+ * @param combos The combos set by the pass
+ * @param textures The textures bound to the pass
+ */
+static CompiledPass compilePass (
+    CContainer* container, const std::string& shader, std::map <std::string, int> combos,
+    const std::vector <std::string>& textures)
+{
+    std::map <std::string, bool> foundCombos;
+    std::map <std::string, CShaderConstant*> constants;
+
+    Compiler fragment (container, shader, Compiler::Type_Pixel, &combos, &foundCombos, textures, constants);
+    fragment.precompile ();
+    Compiler vertex (container, shader, Compiler::Type_Vertex, &combos, &foundCombos, textures, constants);
+    vertex.precompile ();
+
+    return { vertex.getCompiled (), fragment.getCompiled () };
+}
+
+/**
+ * Compares the pre-processed code with the expected one, or stores it as the expected one when updating
+ */
+static void checkGolden (const std::filesystem::path& expected, const std::string& code, bool update)
+{
+    if (update)
+    {
+        std::ofstream (expected, std::ios::binary) << code;
+        return;
+    }
+
+    check (readFile (expected) == code, "pre-processed code matches " + expected.filename ().string ());
+}
+
+/**
+ * The output of the pre-processor for passes that exercise the renames, includes (nested and
+ * with combos), uniform annotations, conditionals and patches has to stay the same
+ */
+static void checkPasses (CContainer* container, const std::filesystem::path& expected, bool update)
+{
+    CompiledPass ripple = compilePass (container, "effects/waterripple", {}, { "", "effects/ripplenormal" });
+
+    checkGolden (expected / "waterripple.vert", ripple.vertex, update);
+    checkGolden (expected / "waterripple.frag", ripple.fragment, update);
+
+    CompiledPass caustics = compilePass (container, "effects/caustics", { { "TEX0FORMAT", 8 } }, { "" });
+
+    checkGolden (expected / "caustics.vert", caustics.vertex, update);
+    checkGolden (expected / "caustics.frag", caustics.fragment, update);
+}
+
+static size_t count (const std::string& code, const std::string& text)
+{
+    size_t result = 0;
+
+    for (size_t position = code.find (text); position != std::string::npos; position = code.find (text, position + text.size ()))
+        result ++;
+
+    return result;
+}
+
+/**
+ * Checks the defines the header gets for the conditionals in the code, nested or not, and for the combos
+ * found by either stage of the pass
+ */
+static void checkConditionals (CContainer* container)
+{
+    CompiledPass pass = compilePass (container, "effects/conditionals", { { "SHADOWS", 1 } }, { "" });
+
+    for (const auto& [stage, code] : { std::make_pair ("vertex", pass.vertex), std::make_pair ("fragment", pass.fragment) })
+    {
+        std::string prefix = std::string (stage) + ": ";
+        // the defines have to be in the header, before the code
+        std::string header = code.substr (0, code.find ("// [COMBO]"));
+
+        check (count (header, "#define LIGHTING 1\n") == 1, prefix + "combos use their default value");
+        check (count (header, "#define VERTEXCOLOR 0\n") == 1, prefix + "combos found by the other stage are defined");
+        check (count (header, "#define SHADOWS 1\n") == 1, prefix + "combos from the pass keep their value");
+        check (count (code, "#define LIGHTING") == 1, prefix + "combos are defined once");
+        check (count (code, "#define SHADOWS") == 1, prefix + "combos from the pass are defined once");
+        check (count (code, "#define VERTEXCOLOR") == 1, prefix + "combos from the other stage are defined once");
+        check (count (code, "#define HAS_FOG") == 0, prefix + "#ifdef names are not defined");
+        check (count (code, "#define QUALITY ") == 0, prefix + "#ifndef names are not defined");
+    }
+
+    // names in nested blocks and in includes are defined to 0 once, no matter how many times they are used
+    check (count (pass.vertex, "#define MORPHING 0\n") == 1, "vertex: nested #if names are defined to 0");
+    check (count (pass.fragment, "#define QUALITY_LOW 0\n") == 1, "fragment: #if names inside #ifndef are defined to 0");
+    check (count (pass.fragment, "#define FOG_DENSITY 0\n") == 1, "fragment: #if names in includes are defined to 0");
+    check (count (pass.vertex, "QUALITY_LOW") == 0, "vertex: names only used by the other stage are not defined");
+    check (count (pass.fragment, "MORPHING") == 0, "fragment: names only used by the other stage are not defined");
+    // include guards are defined by the include itself
+    check (count (pass.fragment, "#define COMMON_CONDITIONALS 0") == 0, "fragment: include guards are not defined to 0");
+
+    // the header is generated every time, the result has to stay the same
+    std::map <std::string, int> combos = { { "SHADOWS", 1 } };
+    std::map <std::string, bool> foundCombos;
+    std::map <std::string, CShaderConstant*> constants;
+    Compiler fragment (container, "effects/conditionals", Compiler::Type_Pixel, &combos, &foundCombos, { "" }, constants);
+
+    fragment.precompile ();
+
+    std::string first = fragment.getCompiled ();
+
+    check (first == fragment.getCompiled (), "generating the header again gives the same code");
+    check (count (first, "#define LIGHTING 1\n") == 1, "combos are defined without the other stage");
+    check (count (first, "#define VERTEXCOLOR 0\n") == 1, "conditionals are defined to 0 without the other stage");
+}
+
+int main (int argc, char* argv [])
+{
+    if (argc < 2)
+    {
+        std::cerr << "usage: " << argv [0] << " <data directory> [--update]" << std::endl;
+        return 1;
+    }
+
+    std::filesystem::path data = argv [1];
+    // regenerates the expected output, the differences have to be reviewed before committing them
+    bool update = argc > 2 && std::string (argv [2]) == "--update";
+    CDirectory container (data);
+
+    checkPasses (&container, data / "expected", update);
+    checkConditionals (&container);
+
+    return failures == 0 ? 0 : 1;
+}
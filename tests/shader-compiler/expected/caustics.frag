@@ -0,0 +1,89 @@
+#version 330
+// ======================================================
+// Processed shader effects/caustics
+// ======================================================
+precision highp float;
+#define mul(x, y) ((y) * (x))
+#define max(x, y) max (y, x)
+#define lerp mix
+#define frac fract
+#define CAST2(x) (vec2(x))
+#define CAST3(x) (vec3(x))
+#define CAST4(x) (vec4(x))
+#define CAST3X3(x) (mat3(x))
+#define saturate(x) (clamp(x, 0.0, 1.0))
+#define texSample2D texture
+#define texSample2DLod textureLod
+#define atan2 atan
+#define fmod(x, y) ((x)-(y)*trunc((x)/(y)))
+#define ddx dFdx
+#define ddy(x) dFdy(-(x))
+#define GLSL 1
+
+layout (std140) uniform FrameGlobals
+{
+    float g_Time;
+    vec2 g_PointerPosition;
+    vec2 g_PointerPositionLast;
+    vec2 g_TexelSize;
+    vec2 g_TexelSizeHalf;
+    float g_AudioSpectrum16Left[16];
+    float g_AudioSpectrum16Right[16];
+    float g_AudioSpectrum32Left[32];
+    float g_AudioSpectrum32Right[32];
+    float g_AudioSpectrum64Left[64];
+    float g_AudioSpectrum64Right[64];
+} g_FrameGlobals;
+
+out vec4 out_FragColor;
+#define varying in
+// ======================================================
+// Shader combo parameter definitions
+// ======================================================
+#define TEX0FORMAT 8
+
+
+varying vec4 v_TexCoord;
+
+uniform sampler2D g_Texture0; // {"hidden":true}
+uniform sampler2D g_Texture1; // {"label":"ui_editor_properties_opacity_mask","mode":"opacitymask","combo":"MASK","paintdefaultcolor":"0 0 0 1"}
+uniform float u_Brightness; // {"material":"brightness","default":1.5}
+uniform vec3 u_WaveColor; // {"material":"color","default":"0.2 0.5 1","type":"color"}
+
+
+
+// begin of included from file common.h
+// shared helpers, the same include is used by both stages
+
+#define M_PI 3.14159265359
+#define M_PI_2 6.28318530718
+
+#define g_Time g_FrameGlobals.g_Time
+
+uniform vec4 g_Texture0Resolution;
+
+
+
+
+
+float greyscale(vec3 color)
+{
+	return dot(color, vec3(0.11, 0.59, 0.3));
+}
+
+vec2 rotateVec2(vec2 v, float r)
+{
+	vec2 cs= vec2(cos(r), sin(r));
+	return vec2(v.x * cs.x - v.y * cs.y, v.x * cs.y + v.y * cs.x);
+}
+
+// end of included from file common.h
+
+
+void main() {
+	vec4 scene= texSample2D(g_Texture0, v_TexCoord.xy);
+	float mask= texSample2D(g_Texture1, v_TexCoord.zw).r;
+	float c= sin(v_TexCoord.x * 40.0 + g_Time) * cos(v_TexCoord.y * 40.0 - g_Time);
+	vec3 colour= vec3(pow(abs(c),  (u_WaveColor * u_Brightness).x));
+	out_FragColor = vec4(mix(scene.rgb, scene.rgb + colour, mask), scene.a);
+}
@@ -0,0 +1,58 @@
+#version 330
+// ======================================================
+// Processed shader effects/caustics
+// ======================================================
+precision highp float;
+#define mul(x, y) ((y) * (x))
+#define max(x, y) max (y, x)
+#define lerp mix
+#define frac fract
+#define CAST2(x) (vec2(x))
+#define CAST3(x) (vec3(x))
+#define CAST4(x) (vec4(x))
+#define CAST3X3(x) (mat3(x))
+#define saturate(x) (clamp(x, 0.0, 1.0))
+#define texSample2D texture
+#define texSample2DLod textureLod
+#define atan2 atan
+#define fmod(x, y) ((x)-(y)*trunc((x)/(y)))
+#define ddx dFdx
+#define ddy(x) dFdy(-(x))
+#define GLSL 1
+
+layout (std140) uniform FrameGlobals
+{
+    float g_Time;
+    vec2 g_PointerPosition;
+    vec2 g_PointerPositionLast;
+    vec2 g_TexelSize;
+    vec2 g_TexelSizeHalf;
+    float g_AudioSpectrum16Left[16];
+    float g_AudioSpectrum16Right[16];
+    float g_AudioSpectrum32Left[32];
+    float g_AudioSpectrum32Right[32];
+    float g_AudioSpectrum64Left[64];
+    float g_AudioSpectrum64Right[64];
+} g_FrameGlobals;
+
+#define attribute in
+#define varying out
+// ======================================================
+// Shader combo parameter definitions
+// ======================================================
+#define TEX0FORMAT 8
+uniform mat4 g_ModelViewProjectionMatrix;
+
+attribute vec3 a_Position;
+attribute vec2 a_TexCoord;
+
+varying vec2 v_TexCoord;
+
+
+
+
+
+void main() {
+	gl_Position = mul(vec4(a_Position, 1.0), g_ModelViewProjectionMatrix);
+	v_TexCoord = a_TexCoord;
+}
@@ -0,0 +1,144 @@
+#version 330
+// ======================================================
+// Processed shader effects/waterripple
+// ======================================================
+precision highp float;
+#define mul(x, y) ((y) * (x))
+#define max(x, y) max (y, x)
+#define lerp mix
+#define frac fract
+#define CAST2(x) (vec2(x))
+#define CAST3(x) (vec3(x))
+#define CAST4(x) (vec4(x))
+#define CAST3X3(x) (mat3(x))
+#define saturate(x) (clamp(x, 0.0, 1.0))
+#define texSample2D texture
+#define texSample2DLod textureLod
+#define atan2 atan
+#define fmod(x, y) ((x)-(y)*trunc((x)/(y)))
+#define ddx dFdx
+#define ddy(x) dFdy(-(x))
+#define GLSL 1
+
+layout (std140) uniform FrameGlobals
+{
+    float g_Time;
+    vec2 g_PointerPosition;
+    vec2 g_PointerPositionLast;
+    vec2 g_TexelSize;
+    vec2 g_TexelSizeHalf;
+    float g_AudioSpectrum16Left[16];
+    float g_AudioSpectrum16Right[16];
+    float g_AudioSpectrum32Left[32];
+    float g_AudioSpectrum32Right[32];
+    float g_AudioSpectrum64Left[64];
+    float g_AudioSpectrum64Right[64];
+} g_FrameGlobals;
+
+out vec4 out_FragColor;
+#define varying in
+// ======================================================
+// Shader combo parameter definitions
+// ======================================================
+#define BLENDMODE 0
+#define NOISE 1
+#define NORMAL 1
+// [COMBO] {"material":"ui_editor_properties_noise","combo":"NOISE","type":"options","default":1}
+
+
+
+
+
+varying vec4 v_TexCoord;
+varying vec2 v_Scroll;
+
+uniform sampler2D g_Texture0; // {"hidden":true}
+uniform sampler2D g_Texture1; // {"label":"ui_editor_properties_normal","mode":"normal","combo":"NORMAL","format":"rg88","paintdefaultcolor":"0 0 0 1"}
+uniform float g_Strength; // {"material":"ripplestrength","label":"ui_editor_properties_ripple_strength","default":0.1,"range":[0,1]}
+uniform vec3 g_Tint; // {"material":"tint","default":"1 0.5 0.25","type":"color"}
+uniform float g_Speed; // {"material":"speed","default":2}
+uniform float g_Weights[4];
+
+
+
+// begin of included from file common.h
+// shared helpers, the same include is used by both stages
+
+#define M_PI 3.14159265359
+#define M_PI_2 6.28318530718
+
+#define g_Time g_FrameGlobals.g_Time
+
+uniform vec4 g_Texture0Resolution;
+
+
+
+
+
+float greyscale(vec3 color)
+{
+	return dot(color, vec3(0.11, 0.59, 0.3));
+}
+
+vec2 rotateVec2(vec2 v, float r)
+{
+	vec2 cs= vec2(cos(r), sin(r));
+	return vec2(v.x * cs.x - v.y * cs.y, v.x * cs.y + v.y * cs.x);
+}
+
+// end of included from file common.h
+// begin of included from file common_blending.h
+// begin of include from file common_composite.h
+/* composite helpers
+   included from other includes */
+
+
+
+
+vec3 BlendScreen(vec3 base, vec3 blend)
+{
+	return 1.0 - ((1.0 - base) * (1.0 - blend));
+}
+
+// end of included from file common_composite.h
+
+
+// [COMBO] {"material":"ui_editor_properties_blend_mode","combo":"BLENDMODE","type":"imageblending","default":0}
+
+
+
+
+
+
+vec3 ApplyBlending(const int blendMode, const vec3 A, const vec3 B, const float opacity)
+{
+#if BLENDMODE == 0
+	return mix(A, B, opacity);
+#else
+	return mix(A, BlendScreen(A, B), opacity);
+#endif
+}
+
+// end of included from file common_blending.h
+
+
+vec4 _sample(vec2 uv)
+{
+	return texSample2D(g_Texture0, uv);
+}
+
+void main() {
+	vec2 texCoord= v_TexCoord.xy + v_Scroll;
+#if NORMAL
+	vec2 normal= texSample2D(g_Texture1, v_TexCoord.zw).xy * 2.0 - 1.0;
+#else
+	vec2 normal= vec2 (0.0, 0.0);
+#endif
+	normal = rotateVec2(normal, g_Time * g_Speed * M_PI_2);
+	vec4 albedo= _sample(texCoord + normal * g_Strength * 0.05);
+#if NOISE
+	albedo.rgb += (frac(sin(dot(texCoord, vec2(12.9898, 78.233))) * 43758.5453) - 0.5) * 1e-2;
+#endif
+	albedo.rgb = ApplyBlending(BLENDMODE, albedo.rgb, g_Tint * g_Weights[0], saturate(g_Strength));
+	out_FragColor = vec4(albedo.rgb, albedo.a * greyscale(albedo.rgb));
+}
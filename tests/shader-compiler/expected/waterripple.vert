@@ -0,0 +1,105 @@
+#version 330
+// ======================================================
+// Processed shader effects/waterripple
+// ======================================================
+precision highp float;
+#define mul(x, y) ((y) * (x))
+#define max(x, y) max (y, x)
+#define lerp mix
+#define frac fract
+#define CAST2(x) (vec2(x))
+#define CAST3(x) (vec3(x))
+#define CAST4(x) (vec4(x))
+#define CAST3X3(x) (mat3(x))
+#define saturate(x) (clamp(x, 0.0, 1.0))
+#define texSample2D texture
+#define texSample2DLod textureLod
+#define atan2 atan
+#define fmod(x, y) ((x)-(y)*trunc((x)/(y)))
+#define ddx dFdx
+#define ddy(x) dFdy(-(x))
+#define GLSL 1
+
+layout (std140) uniform FrameGlobals
+{
+    float g_Time;
+    vec2 g_PointerPosition;
+    vec2 g_PointerPositionLast;
+    vec2 g_TexelSize;
+    vec2 g_TexelSizeHalf;
+    float g_AudioSpectrum16Left[16];
+    float g_AudioSpectrum16Right[16];
+    float g_AudioSpectrum32Left[32];
+    float g_AudioSpectrum32Right[32];
+    float g_AudioSpectrum64Left[64];
+    float g_AudioSpectrum64Right[64];
+} g_FrameGlobals;
+
+#define attribute in
+#define varying out
+// ======================================================
+// Shader combo parameter definitions
+// ======================================================
+#define BLENDMODE 0
+#define NOISE 1
+#define NORMAL 1
+
+
+
+uniform mat4 g_ModelViewProjectionMatrix;
+uniform vec4 g_Texture1Resolution;
+uniform vec2 g_ScrollSpeed; // {"material":"scrollspeed","default":"0.1 0.2"}
+
+attribute vec3 a_Position;
+attribute vec2 a_TexCoord;
+
+varying vec4 v_TexCoord;
+varying vec2 v_Scroll;
+
+
+
+// begin of included from file common.h
+// shared helpers, the same include is used by both stages
+
+#define M_PI 3.14159265359
+#define M_PI_2 6.28318530718
+
+#define g_Time g_FrameGlobals.g_Time
+
+uniform vec4 g_Texture0Resolution;
+
+
+
+
+
+float greyscale(vec3 color)
+{
+	return dot(color, vec3(0.11, 0.59, 0.3));
+}
+
+vec2 rotateVec2(vec2 v, float r)
+{
+	vec2 cs= vec2(cos(r), sin(r));
+	return vec2(v.x * cs.x - v.y * cs.y, v.x * cs.y + v.y * cs.x);
+}
+
+// end of included from file common.h
+// begin of included from file common_vertex.h
+
+
+
+
+vec4 computeScreenPos(vec4 position)
+{
+	return vec4(position.xy * 0.5 + position.w * 0.5, position.zw);
+}
+
+// end of included from file common_vertex.h
+
+
+void main() {
+	gl_Position = mul(vec4(a_Position, 1.0), g_ModelViewProjectionMatrix);
+	v_TexCoord.xy = a_TexCoord;
+	v_TexCoord.zw = a_TexCoord * g_Texture1Resolution.zw / g_Texture1Resolution.xy;
+	v_Scroll = frac(g_ScrollSpeed * g_Time);
+}
@@ -0,0 +1,18 @@
+// shared helpers, the same include is used by both stages
+
+#define M_PI 3.14159265359
+#define M_PI_2 6.28318530718
+
+uniform float g_Time;
+uniform vec4 g_Texture0Resolution;
+
+float greyscale(vec3 color)
+{
+	return dot(color, vec3(0.11, 0.59, 0.3));
+}
+
+vec2 rotateVec2(vec2 v, float r)
+{
+	vec2 cs = vec2(cos(r), sin(r));
+	return vec2(v.x * cs.x - v.y * cs.y, v.x * cs.y + v.y * cs.x);
+}
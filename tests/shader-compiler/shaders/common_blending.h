@@ -0,0 +1,12 @@
+#include "common_composite.h"
+
+// [COMBO] {"material":"ui_editor_properties_blend_mode","combo":"BLENDMODE","type":"imageblending","default":0}
+
+vec3 ApplyBlending(const int blendMode, const vec3 A, const vec3 B, const float opacity)
+{
+#if BLENDMODE == 0
+	return mix(A, B, opacity);
+#else
+	return mix(A, BlendScreen(A, B), opacity);
+#endif
+}
@@ -0,0 +1,6 @@
+/* composite helpers
+   included from other includes */
+vec3 BlendScreen(vec3 base, vec3 blend)
+{
+	return 1.0 - ((1.0 - base) * (1.0 - blend));
+}
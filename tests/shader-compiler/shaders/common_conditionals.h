@@ -0,0 +1,12 @@
+#ifndef COMMON_CONDITIONALS
+#define COMMON_CONDITIONALS 1
+
+vec3 applyFog(vec3 color, float depth)
+{
+#if FOG_DENSITY
+	color = mix(color, vec3(0.5, 0.5, 0.5), saturate(depth * 0.1));
+#endif
+	return color;
+}
+
+#endif
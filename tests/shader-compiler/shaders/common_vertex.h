@@ -0,0 +1,4 @@
+vec4 computeScreenPos(vec4 position)
+{
+	return vec4(position.xy * 0.5 + position.w * 0.5, position.zw);
+}
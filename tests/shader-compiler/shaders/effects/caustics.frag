@@ -0,0 +1,16 @@
+#include "common.h"
+
+varying vec2 v_TexCoord;
+
+uniform sampler2D g_Texture0; // {"hidden":true}
+uniform sampler2D g_Texture1; // {"label":"ui_editor_properties_opacity_mask","mode":"opacitymask","combo":"MASK","paintdefaultcolor":"0 0 0 1"}
+uniform float u_Brightness; // {"material":"brightness","default":1.5}
+uniform vec3 u_WaveColor; // {"material":"color","default":"0.2 0.5 1","type":"color"}
+
+void main() {
+	vec4 scene= texSample2D(g_Texture0, v_TexCoord);
+	float mask= texSample2D(g_Texture1, v_TexCoord.zw).r;
+	float c = sin(v_TexCoord.x * 40.0 + g_Time) * cos(v_TexCoord.y * 40.0 - g_Time);
+	vec3 colour= vec3(pow(abs(c),  u_WaveColor * u_Brightness));
+	gl_FragColor = vec4(mix(scene.rgb, scene.rgb + colour, mask), scene.a);
+}
@@ -0,0 +1,33 @@
+// [COMBO] {"material":"ui_editor_properties_lighting","combo":"LIGHTING","type":"options","default":1}
+
+#include "common_conditionals.h"
+
+varying vec2 v_TexCoord;
+varying vec4 v_Color;
+
+uniform sampler2D g_Texture0; // {"hidden":true}
+
+void main() {
+	vec4 color = texSample2D(g_Texture0, v_TexCoord);
+#if LIGHTING
+#if SHADOWS
+	color.rgb *= 0.5;
+#else
+#ifdef HAS_FOG
+	color.rgb = applyFog(color.rgb, v_TexCoord.y);
+#endif
+#endif
+#endif
+#ifndef QUALITY
+#if QUALITY_LOW && SHADOWS
+	color.a = 1.0;
+#endif
+#endif
+#if VERTEXCOLOR
+	color *= v_Color;
+#endif
+#if LIGHTING
+	color.rgb = saturate(color.rgb);
+#endif
+	gl_FragColor = color;
+}
@@ -0,0 +1,25 @@
+// [COMBO] {"material":"ui_editor_properties_vertex_color","combo":"VERTEXCOLOR","type":"options","default":0}
+
+uniform mat4 g_ModelViewProjectionMatrix;
+
+attribute vec3 a_Position;
+attribute vec2 a_TexCoord;
+attribute vec4 a_Color;
+
+varying vec2 v_TexCoord;
+varying vec4 v_Color;
+
+void main() {
+	gl_Position = mul(vec4(a_Position, 1.0), g_ModelViewProjectionMatrix);
+	v_TexCoord = a_TexCoord;
+#if VERTEXCOLOR
+	v_Color = a_Color;
+#else
+	v_Color = vec4(1.0, 1.0, 1.0, 1.0);
+#endif
+#if SHADOWS
+#if MORPHING
+	gl_Position.z += 0.001;
+#endif
+#endif
+}
@@ -0,0 +1,35 @@
+// [COMBO] {"material":"ui_editor_properties_noise","combo":"NOISE","type":"options","default":1}
+
+#include "common.h"
+#include "common_blending.h"
+
+varying vec4 v_TexCoord;
+varying vec2 v_Scroll;
+
+uniform sampler2D g_Texture0; // {"hidden":true}
+uniform sampler2D g_Texture1; // {"label":"ui_editor_properties_normal","mode":"normal","combo":"NORMAL","format":"rg88","paintdefaultcolor":"0 0 0 1"}
+uniform float g_Strength; // {"material":"ripplestrength","label":"ui_editor_properties_ripple_strength","default":0.1,"range":[0,1]}
+uniform vec3 g_Tint; // {"material":"tint","default":"1 0.5 0.25","type":"color"}
+uniform highp float g_Speed; // {"material":"speed","default":2}
+uniform float g_Weights[4];
+
+vec4 sample(vec2 uv)
+{
+	return texSample2D(g_Texture0, uv);
+}
+
+void main() {
+	vec2 texCoord = v_TexCoord.xy + v_Scroll;
+#if NORMAL
+	vec2 normal = texSample2D(g_Texture1, v_TexCoord.zw).xy * 2.0 - 1.0;
+#else
+	vec2 normal = vec2 (0.0, 0.0);
+#endif
+	normal = rotateVec2(normal, g_Time * g_Speed * M_PI_2);
+	vec4 albedo = sample(texCoord + normal * g_Strength * 0.05);
+#if NOISE
+	albedo.rgb += (frac(sin(dot(texCoord, vec2(12.9898, 78.233))) * 43758.5453) - 0.5) * 1e-2;
+#endif
+	albedo.rgb = ApplyBlending(BLENDMODE, albedo.rgb, g_Tint * g_Weights[0], saturate(g_Strength));
+	gl_FragColor = vec4(albedo.rgb, albedo.a * greyscale(albedo.rgb));
+}
@@ -0,0 +1,19 @@
+#include "common.h"
+#include "common_vertex.h"
+
+uniform mat4 g_ModelViewProjectionMatrix;
+uniform vec4 g_Texture1Resolution;
+uniform vec2 g_ScrollSpeed; // {"material":"scrollspeed","default":"0.1 0.2"}
+
+attribute vec3 a_Position;
+attribute vec2 a_TexCoord;
+
+varying vec4 v_TexCoord;
+varying vec2 v_Scroll;
+
+void main() {
+	gl_Position = mul(vec4(a_Position, 1.0), g_ModelViewProjectionMatrix);
+	v_TexCoord.xy = a_TexCoord;
+	v_TexCoord.zw = a_TexCoord * g_Texture1Resolution.zw / g_Texture1Resolution.xy;
+	v_Scroll = frac(g_ScrollSpeed * g_Time);
+}